@@ -0,0 +1,31 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<unsigned long long> allocationCount(0);
+
+unsigned long long getAllocationCount() {
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+//Every other form of new and delete ends up in these
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	void* allocation = malloc(size > 0 ? size : 1);
+	if (allocation == NULL) {
+		throw std::bad_alloc();
+	}
+	return allocation;
+}
+
+void operator delete(void* allocation) noexcept {
+	free(allocation);
+}
+
+//C++14 calls this one when the size is known, it has to free the same way
+void operator delete(void* allocation, size_t) noexcept {
+	free(allocation);
+}
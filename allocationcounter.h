@@ -0,0 +1,5 @@
+#pragma once
+
+//Heap allocations made by any thread so far. Only counts when allocationcounter.cpp is linked in, which replaces the
+//global operator new, so Alien8Bench links it and the game does not
+unsigned long long getAllocationCount();
@@ -0,0 +1,849 @@
+#include "allocationcounter.h"
+#include "bmp.h"
+#include "game.h"
+#include "golden.h"
+#include "hash.h"
+#include "kernels.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "replay.h"
+#include "renderer.h"
+#include "tilemap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+//Headless frame benchmark: runs tick() + render uncapped, no window or GL needed
+
+static const char* USAGE =
+"[--frames N] [--sprites N] [--format rgba|indexed|spectrum] [--threads N] [--damage]\n"
+"  --compare        time the old rescanning renderer against the current one\n"
+"  --sprite-layout  time moving and painting sprites kept one array per field against heap objects behind pointers\n"
+"  --kernels        time the SIMD pixel kernels against the scalar ones\n"
+"  --load-bmp FILE  time opening and converting a BMP, against reading it into a buffer first\n"
+"  --check-threads  render with --threads and with one thread and compare frame hashes\n"
+"  --profile FILE   write a Chrome trace of the frame stages and print their percentiles\n"
+"  --golden DIR     paint the golden scenes every way the renderer can and compare them with the images in DIR\n"
+"  --update-golden DIR  write the golden images to DIR instead\n"
+"  --replay FILE    play back a recorded session as fast as possible, ticks alone and then ticking and painting.\n"
+"                   It is painted over the scene the log names, or --scene to compare against another one\n"
+"  --scene FILE     paint the frames over FILE cut into tiles, and print how small the tiles are\n"
+"  --scroll N       lay the --scene out N times each way and sweep the view across it. --check-threads then also\n"
+"                   checks the tiles streamed in as it scrolls against decoding every tile in view each frame\n"
+"  --pipeline N     simulate and render on their own threads, N frames deep, and check every frame against its state\n";
+
+//Frames after these are steady state, where nothing may be allocated any more
+static const int WARMUP_FRAMES = 10;
+
+static unsigned int seed = 12345;
+
+//Set by --scene, every mode that ticks the game draws it behind the sprites
+static const TileMap* background = NULL;
+//Set by --scroll, the modes that paint frames themselves move the view every frame
+static bool scrolling = false;
+
+//Fixed seed LCG, so every run scatters the sprites the same way
+unsigned char nextRandom() {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0xFF;
+}
+
+void addSprites(Game& game, int count) {
+	for (int i = 0; i < count; i++) {
+		unsigned char x = nextRandom();
+		unsigned char y = nextRandom();
+		game.sprites.add(x, y);
+	}
+}
+
+//Walk the player around in a square, changing direction every 64 ticks
+Input scriptedInput(int frame) {
+	Input input;
+	switch ((frame / 64) % 4) {
+	case 0: input.right = true; break;
+	case 1: input.down = true; break;
+	case 2: input.left = true; break;
+	case 3: input.up = true; break;
+	}
+	return input;
+}
+
+//Back and forth between 0 and range, distance being how far it has gone in all
+static int bounce(int distance, int range) {
+	if (range <= 0) {
+		return 0;
+	}
+	distance %= 2 * range;
+	return distance <= range ? distance : 2 * range - distance;
+}
+
+//Sweep the view across the whole background, 3 pixels a frame sideways and 1 down, so it keeps crossing tile edges
+//at every offset into a tile
+static void scrollView(Game& game, int frame) {
+	if (!scrolling || game.background == NULL) {
+		return;
+	}
+	game.scrollX = bounce(frame * 3, game.background->getColumns() * TILE_SIZE - SCREEN_WIDTH);
+	game.scrollY = bounce(frame, game.background->getRows() * TILE_SIZE - SCREEN_HEIGHT);
+}
+
+//The original repaint, which walks every sprite at the start of each scanline and tests every sprite on every pixel.
+//Kept as the reference for --compare
+void renderRescan(const Game& game, unsigned char* imageData) {
+	std::vector<unsigned char> spritesForScanline; //x of every sprite on the scanline
+
+	for (int i = 0; i < Renderer::IMAGE_DATA_LENGTH; i += 4) {
+		int pixelIndex = i / 4;
+		int x = pixelIndex % SCREEN_WIDTH;
+		int y = pixelIndex / SCREEN_WIDTH;
+
+		imageData[i] = 0;
+		imageData[i + 1] = 0;
+		imageData[i + 2] = 0;
+		imageData[i + 3] = 255;
+
+		//See if any sprites need to be drawn this scanline
+		if (x == 0) {
+			spritesForScanline.clear();
+
+			for (size_t sprite = 0; sprite < game.sprites.size(); sprite++) {
+				if (game.sprites.y[sprite] >= y && game.sprites.y[sprite] <= y + 8) {
+					spritesForScanline.push_back(game.sprites.x[sprite]);
+				}
+			}
+		}
+
+		//Draw sprites from current scanline
+		for (auto const& value : spritesForScanline) {
+			if (value >= x && value <= x + 8) {
+				imageData[i + 1] = 255; //Make it green, for now
+			}
+		}
+	}
+}
+
+//Times the rescanning reference against the renderer for growing sprite counts
+void compareSprites() {
+	const int spriteCounts[] = { 10, 1000, 10000 };
+	const int frames = 100;
+
+	unsigned char* before = new unsigned char[Renderer::IMAGE_DATA_LENGTH];
+	unsigned char* after = new unsigned char[Renderer::IMAGE_DATA_LENGTH];
+	Renderer renderer;
+
+	for (int count : spriteCounts) {
+		Game game;
+		game.sprites.clear();
+		seed = 12345;
+		addSprites(game, count);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < frames; frame++) {
+			renderRescan(game, before);
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < frames; frame++) {
+			renderer.render(game, after);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		long long rescanNs = std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count() / frames;
+		long long binnedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count() / frames;
+		bool identical = memcmp(before, after, Renderer::IMAGE_DATA_LENGTH) == 0;
+
+		std::cout << count << " sprites: rescan " << rescanNs << " ns/frame, binned spans " << binnedNs << " ns/frame"
+			<< (identical ? "" : " (OUTPUT DIFFERS)") << std::endl;
+	}
+
+	delete[] before;
+	delete[] after;
+}
+
+//How sprites used to be kept, one heap object each with the game holding pointers to them
+struct PointerSprite {
+	unsigned char x;
+	unsigned char y;
+	unsigned char width;
+	unsigned char height;
+	unsigned char image;
+	unsigned char flags;
+};
+
+//The same move every --sprite-layout frame makes, and --check-threads too
+static void moveSprite(size_t i, unsigned char& x, unsigned char& y) {
+	x += (i % 3) - 1;
+	y += (i % 5) / 2 - 1;
+}
+
+//Bin and paint like Renderer does, but chasing a pointer for every sprite
+static void renderPointers(const std::vector<PointerSprite*>& sprites, std::vector<const PointerSprite*>* rows, uint32_t* pixels) {
+	uint32_t black;
+	uint32_t green;
+	Palette palette;
+	memcpy(&black, palette.colors[PALETTE_BLACK], 4);
+	memcpy(&green, palette.colors[PALETTE_BRIGHT + PALETTE_GREEN], 4);
+
+	for (int y = 0; y < (int)SCREEN_HEIGHT; y++) {
+		rows[y].clear();
+	}
+	for (auto const& sprite : sprites) {
+		int top = std::max(sprite->y - sprite->height + 1, 0);
+		int bottom = std::min((int)sprite->y, (int)SCREEN_HEIGHT - 1);
+		if (sprite->x - sprite->width + 1 > (int)SCREEN_WIDTH - 1) {
+			continue;
+		}
+		for (int y = top; y <= bottom; y++) {
+			rows[y].push_back(sprite);
+		}
+	}
+
+	for (int y = 0; y < (int)SCREEN_HEIGHT; y++) {
+		uint32_t* row = pixels + y * SCREEN_WIDTH;
+		pixelKernels().fill(row, SCREEN_WIDTH, black);
+		for (auto const& sprite : rows[y]) {
+			int left = std::max(sprite->x - sprite->width + 1, 0);
+			int right = std::min((int)sprite->x, (int)SCREEN_WIDTH - 1);
+			if (left <= right) {
+				pixelKernels().fill(row + left, right - left + 1, green);
+			}
+		}
+	}
+}
+
+//Moves every sprite and paints a frame, with sprites in a SpriteStore and as heap objects behind a shuffled pointer vector
+void compareSpriteLayouts(int frames) {
+	const int spriteCounts[] = { 1000, 10000 };
+
+	for (int count : spriteCounts) {
+		Game game;
+		game.sprites.clear();
+		seed = 12345;
+		addSprites(game, count);
+
+		//Allocated in one order and walked in another, the way objects created and destroyed over a game end up
+		std::vector<PointerSprite*> pointers;
+		for (size_t i = 0; i < game.sprites.size(); i++) {
+			pointers.push_back(new PointerSprite{ game.sprites.x[i], game.sprites.y[i], 9, 9, 0, 0 });
+		}
+		std::vector<size_t> order(pointers.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		for (size_t i = order.size() - 1; i > 0; i--) {
+			std::swap(order[i], order[((size_t)nextRandom() << 8 | nextRandom()) % (i + 1)]);
+		}
+		std::vector<PointerSprite*> shuffled;
+		for (size_t i : order) {
+			shuffled.push_back(pointers[i]);
+		}
+
+		Renderer renderer;
+		std::vector<unsigned char> storeImage(renderer.getImageDataLength());
+		std::vector<uint32_t> pointerImage(SCREEN_WIDTH * SCREEN_HEIGHT);
+		std::vector<const PointerSprite*> rows[SCREEN_HEIGHT];
+		long long storeMoveNs = 0;
+		long long storePaintNs = 0;
+		long long pointerMoveNs = 0;
+		long long pointerPaintNs = 0;
+
+		for (int frame = 0; frame < frames; frame++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < game.sprites.size(); i++) {
+				moveSprite(i, game.sprites.x[i], game.sprites.y[i]);
+			}
+			auto moved = std::chrono::high_resolution_clock::now();
+			renderer.render(game, storeImage.data());
+			auto painted = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < shuffled.size(); i++) {
+				moveSprite(order[i], shuffled[i]->x, shuffled[i]->y);
+			}
+			auto pointersMoved = std::chrono::high_resolution_clock::now();
+			renderPointers(shuffled, rows, pointerImage.data());
+			auto pointersPainted = std::chrono::high_resolution_clock::now();
+
+			storeMoveNs += std::chrono::duration_cast<std::chrono::nanoseconds>(moved - start).count();
+			storePaintNs += std::chrono::duration_cast<std::chrono::nanoseconds>(painted - moved).count();
+			pointerMoveNs += std::chrono::duration_cast<std::chrono::nanoseconds>(pointersMoved - painted).count();
+			pointerPaintNs += std::chrono::duration_cast<std::chrono::nanoseconds>(pointersPainted - pointersMoved).count();
+		}
+
+		bool identical = memcmp(storeImage.data(), pointerImage.data(), storeImage.size()) == 0;
+		std::cout << count << " sprites: store move " << storeMoveNs / frames << " ns + paint " << storePaintNs / frames
+			<< " ns/frame, pointers move " << pointerMoveNs / frames << " ns + paint " << pointerPaintNs / frames << " ns/frame"
+			<< (identical ? "" : " (OUTPUT DIFFERS)") << std::endl;
+
+		for (auto const& sprite : pointers) {
+			delete sprite;
+		}
+	}
+}
+
+template <typename Kernel>
+double timeKernel(Kernel kernel, int iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		kernel(i);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+//Times every kernel version on screen sized work and checks each one paints the same pixels as the scalar version
+void benchKernels() {
+	const int pixels = SCREEN_WIDTH * SCREEN_HEIGHT;
+	const int iterations = 20000;
+	const uint32_t colorKey = 0xFF00FF00;
+	const PixelKernels* versions[] = { &scalarKernels(), sse2Kernels(), avx2Kernels() };
+	const char* kernelNames[] = { "clear (whole screen)", "fill (9 pixel spans)", "blit (whole screen)", "masked blit (whole screen)",
+		"BGR to RGBA (whole screen)" };
+	const int kernelCount = sizeof(kernelNames) / sizeof(kernelNames[0]);
+
+	//A source with a quarter of its pixels set to the colour key
+	std::vector<uint32_t> source(pixels);
+	for (auto& pixel : source) {
+		pixel = nextRandom() < 64 ? colorKey : nextRandom() * 0x01010101u;
+	}
+
+	std::vector<unsigned char> bgr(pixels * 3);
+	for (auto& component : bgr) {
+		component = nextRandom();
+	}
+
+	std::vector<uint32_t> expected[kernelCount];
+	double scalarNs[kernelCount];
+
+	std::cout << "Using " << pixelKernels().name << " kernels" << std::endl;
+
+	for (const PixelKernels* version : versions) {
+		if (version == NULL) {
+			continue;
+		}
+
+		for (int kernel = 0; kernel < kernelCount; kernel++) {
+			std::vector<uint32_t> result(pixels, 0xFF000000);
+			double ns = 0.0;
+
+			switch (kernel) {
+			case 0:
+				ns = timeKernel([&](int i) { version->fill(result.data(), pixels, 0xFF000000 | i); }, iterations);
+				version->fill(result.data(), pixels, 0xFF000000);
+				break;
+			case 1:
+				ns = timeKernel([&](int i) { version->fill(result.data() + (i * 9) % (pixels - 9), 9, 0xFF00FF00); }, iterations);
+				break;
+			case 2:
+				ns = timeKernel([&](int) { version->blit(result.data(), source.data(), pixels); }, iterations);
+				break;
+			case 3:
+				ns = timeKernel([&](int) { version->blitMasked(result.data(), source.data(), pixels, colorKey); }, iterations);
+				break;
+			case 4:
+				ns = timeKernel([&](int) { version->bgrToRgba(result.data(), bgr.data(), pixels); }, iterations);
+				break;
+			}
+
+			if (version == &scalarKernels()) {
+				expected[kernel] = result;
+				scalarNs[kernel] = ns;
+			}
+
+			std::cout << version->name << " " << kernelNames[kernel] << ": " << ns << " ns, " << scalarNs[kernel] / ns << "x scalar"
+				<< (result == expected[kernel] ? "" : " (OUTPUT DIFFERS)") << std::endl;
+		}
+	}
+}
+
+//Time opening a BMP and turning it into RGBA through the mapping, with the best and the scalar kernels, against
+//reading the whole file into a buffer and converting from there. Every way has to give the same pixels
+int benchLoadBmp(const char* path) {
+	const int iterations = 2000;
+
+	BmpFile file;
+	if (!file.open(path)) {
+		std::cout << "Could not read " << path << std::endl;
+		return 1;
+	}
+	int width = file.getWidth();
+	int height = file.getHeight();
+	std::cout << path << ": " << width << "x" << height << ", " << file.getBitsPerPixel() << " bits per pixel, "
+		<< (file.isTopDown() ? "top down" : "bottom up") << std::endl;
+	file.close();
+
+	std::vector<unsigned char> expected(width * height * 4);
+	std::vector<unsigned char> rgba(width * height * 4);
+
+	double headersNs = timeKernel([&](int) {
+		file.open(path);
+	}, iterations);
+
+	double mappedNs = timeKernel([&](int) {
+		file.open(path);
+		file.toRgba(rgba.data(), width * 4);
+	}, iterations);
+
+	double scalarNs = timeKernel([&](int) {
+		file.open(path);
+		for (int y = 0; y < height; y++) {
+			scalarKernels().bgrToRgba((uint32_t*)(expected.data() + y * width * 4), file.getRow(y), width);
+		}
+	}, iterations);
+	bool scalarSame = file.getBitsPerPixel() != 24 || rgba == expected;
+
+	//The old way, a copy of the whole file in memory first and a scalar loop over that
+	std::vector<char> buffer;
+	std::vector<unsigned char> buffered(width * height * 4);
+	double bufferedNs = timeKernel([&](int) {
+		std::ifstream stream(path, std::ios::binary);
+		stream.seekg(0, stream.end);
+		buffer.resize((size_t)stream.tellg());
+		stream.seekg(0, stream.beg);
+		stream.read(buffer.data(), buffer.size());
+
+		const unsigned char* bytes = (const unsigned char*)buffer.data();
+		size_t offset = bytes[10] | bytes[11] << 8 | bytes[12] << 16 | (size_t)bytes[13] << 24;
+		int stride = (width * 3 + 3) & ~3;
+		for (int y = 0; y < height; y++) {
+			const unsigned char* row = bytes + offset + (size_t)(file.isTopDown() ? y : height - 1 - y) * stride;
+			unsigned char* pixel = buffered.data() + y * width * 4;
+			for (int x = 0; x < width; x++) {
+				pixel[x * 4] = row[x * 3 + 2];
+				pixel[x * 4 + 1] = row[x * 3 + 1];
+				pixel[x * 4 + 2] = row[x * 3];
+				pixel[x * 4 + 3] = 255;
+			}
+		}
+	}, file.getBitsPerPixel() == 24 ? iterations : 0);
+	bool bufferedSame = file.getBitsPerPixel() != 24 || buffered == expected;
+
+	std::cout << "open and parse headers:    " << headersNs << " ns" << std::endl;
+	std::cout << "open and convert (" << pixelKernels().name << "):   " << mappedNs << " ns" << std::endl;
+	std::cout << "open and convert (scalar): " << scalarNs << " ns" << (scalarSame ? "" : " (OUTPUT DIFFERS)") << std::endl;
+	if (file.getBitsPerPixel() == 24) {
+		std::cout << "read into a buffer first:  " << bufferedNs << " ns" << (bufferedSame ? "" : " (OUTPUT DIFFERS)") << std::endl;
+	}
+
+	return scalarSame && bufferedSame ? 0 : 1;
+}
+
+//Render the same frames with the band renderer and a single thread, full and damaged, and report the first frame that
+//differs. When scrolling the single thread renderer decodes every tile in view each frame, and the others only the
+//tiles that scrolled in
+int checkThreads(PixelFormat format, int threads, int frames, int extraSprites) {
+	Game game;
+	game.background = background;
+	addSprites(game, extraSprites);
+	Renderer single(format, 1);
+	Renderer banded(format, threads);
+	Renderer bandedDamage(format, threads);
+	std::vector<unsigned char> expected(single.getImageDataLength());
+	std::vector<unsigned char> actual(single.getImageDataLength());
+	std::vector<unsigned char> actualDamage(single.getImageDataLength());
+	Damage damage;
+
+	for (int frame = 0; frame < frames; frame++) {
+		tick(game, scriptedInput(frame));
+		//Move the extra sprites around too, so the damage is spread over every band
+		for (size_t i = 1; i < game.sprites.size(); i++) {
+			moveSprite(i, game.sprites.x[i], game.sprites.y[i]);
+		}
+		scrollView(game, frame);
+
+		if (scrolling) {
+			single.invalidate();
+		}
+		single.render(game, expected.data());
+		banded.render(game, actual.data());
+		bandedDamage.findDamage(game, damage);
+		bandedDamage.render(game, actualDamage.data(), damage);
+
+		unsigned long long expectedHash = hashBytes(expected.data(), expected.size());
+		if (hashBytes(actual.data(), actual.size()) != expectedHash || hashBytes(actualDamage.data(), actualDamage.size()) != expectedHash) {
+			std::cout << "Frame " << frame << " differs with " << threads << " threads" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << frames << " frames identical with " << threads << " threads" << std::endl;
+	return 0;
+}
+
+long long percentile(const std::vector<long long>& sorted, double p) {
+	size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+//Present frames from the threaded pipeline as fast as it makes them, re-rendering each one from the state it carries
+int benchPipeline(PixelFormat format, int depth, int threads, int frames, int extraSprites) {
+	Game game;
+	game.background = background;
+	addSprites(game, extraSprites);
+	Renderer single(format, 1);
+	std::vector<unsigned char> expected(single.getImageDataLength());
+	std::vector<long long> waitNs(frames);
+	unsigned long long lastSequence = 0;
+	int result = 0;
+
+	InputQueue inputs;
+	Input input;
+	Pipeline pipeline(game, inputs, format, depth, threads);
+
+	unsigned long long warmAllocations = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		if (frame == WARMUP_FRAMES) {
+			warmAllocations = getAllocationCount();
+		}
+
+		Input next = scriptedInput(frame);
+		inputs.pushChanges(input, next, Profiler::now());
+		input = next;
+
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		const Frame* presented = pipeline.nextFrame();
+		waitNs[frame] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - waitStart).count();
+
+		single.render(presented->state, expected.data());
+		if (result == 0 && (presented->sequence != lastSequence + 1 || presented->imageData != expected)) {
+			std::cout << "Frame " << frame << " (sequence " << presented->sequence << ") does not match its state" << std::endl;
+			result = 1;
+		}
+		lastSequence = presented->sequence;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	unsigned long long steadyAllocations = frames > WARMUP_FRAMES ? getAllocationCount() - warmAllocations : 0;
+
+	double totalSeconds = std::chrono::duration<double>(end - start).count();
+	std::sort(waitNs.begin(), waitNs.end());
+
+	std::cout << frames << " frames, " << game.sprites.size() << " sprites, " << threads << " threads, pipeline depth " << depth << std::endl;
+	std::cout << "frames/sec: " << frames / totalSeconds << std::endl;
+	std::cout << "wait p50: " << percentile(waitNs, 0.50) << " ns, p95: " << percentile(waitNs, 0.95)
+		<< " ns, p99: " << percentile(waitNs, 0.99) << " ns, max: " << waitNs.back() << " ns" << std::endl;
+	if (result == 0) {
+		std::cout << "Every frame matches its state" << std::endl;
+	}
+	std::cout << "heap allocations after warm-up: " << steadyAllocations << std::endl;
+
+	return result != 0 || steadyAllocations > 0 ? 1 : 0;
+}
+
+//Replay a session recorded with Alien8 --record, once only ticking and once ticking and painting every tick.
+//Recorded hashes are checked along the way, the frame hashes only when painting in the format they were taken in
+int benchReplay(const char* path, PixelFormat format, int threads) {
+	InputLog log;
+	if (!log.load(path)) {
+		std::cout << "Could not read replay " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << log.getTickCount() << " ticks";
+	if (log.getTickRate() > 0.0) {
+		std::cout << " (" << log.getTickCount() / log.getTickRate() << " s at " << log.getTickRate() << " Hz)";
+	}
+	if (!log.getScene().empty()) {
+		std::cout << " over " << log.getScene();
+	}
+	std::cout << std::endl;
+
+	const std::vector<InputLog::TickHashes>& expected = log.getHashes();
+	bool checkFrames = !expected.empty() && format == Recorder::FRAME_FORMAT;
+	size_t tickIndex = 0;
+	long long firstBadState = -1;
+	long long firstBadFrame = -1;
+
+	Game simulated;
+	auto start = std::chrono::high_resolution_clock::now();
+	log.forEachTick([&](const Input& input) {
+		tick(simulated, input);
+	});
+	double tickSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	//The frame hashes were taken over the background the session had, so that one unless --scene asks for another
+	TileMap scene;
+	const TileMap* replayBackground = background;
+	if (replayBackground == NULL && !log.getScene().empty()) {
+		if (!scene.load(log.getScene().c_str(), Palette())) {
+			std::cout << "Could not read " << log.getScene() << ", the scene the replay was recorded over" << std::endl;
+			return 1;
+		}
+		replayBackground = &scene;
+	}
+
+	Game game;
+	game.background = replayBackground;
+	Renderer renderer(format, threads);
+	std::vector<unsigned char> imageData(renderer.getImageDataLength());
+	std::vector<long long> frameNs;
+	frameNs.reserve(log.getTickCount());
+	Damage damage;
+
+	start = std::chrono::high_resolution_clock::now();
+	log.forEachTick([&](const Input& input) {
+		auto frameStart = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE("tick");
+			tick(game, input);
+		}
+		PROFILE_SCOPE("paint");
+		renderer.findDamage(game, damage);
+		renderer.render(game, imageData.data(), damage);
+
+		//Cheap enough to stay inside the timed frame, which shows what it costs
+		if (!expected.empty()) {
+			PROFILE_SCOPE("hash");
+			if (firstBadState < 0 && hashGame(game) != expected[tickIndex].state) {
+				firstBadState = tickIndex;
+			}
+			if (checkFrames && firstBadFrame < 0 && hashBytes(imageData.data(), imageData.size()) != expected[tickIndex].frame) {
+				firstBadFrame = tickIndex;
+			}
+		}
+		tickIndex++;
+
+		frameNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - frameStart).count());
+	});
+	double frameSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if (frameNs.empty()) {
+		return 0;
+	}
+	std::sort(frameNs.begin(), frameNs.end());
+
+	size_t player = game.sprites.indexOf(game.player);
+	std::cout << "ticks/sec:  " << log.getTickCount() / tickSeconds << std::endl;
+	std::cout << "frames/sec: " << log.getTickCount() / frameSeconds << std::endl;
+	std::cout << "p50: " << percentile(frameNs, 0.50) << " ns, p95: " << percentile(frameNs, 0.95)
+		<< " ns, p99: " << percentile(frameNs, 0.99) << " ns, max: " << frameNs.back() << " ns" << std::endl;
+	std::cout << "player ends at " << (int)game.sprites.x[player] << "," << (int)game.sprites.y[player] << std::endl;
+
+	if (expected.empty()) {
+		std::cout << "No hashes recorded, nothing to check" << std::endl;
+		return 0;
+	}
+	if (firstBadState >= 0) {
+		std::cout << "State diverges at tick " << firstBadState << std::endl;
+	}
+	if (firstBadFrame >= 0) {
+		std::cout << "Frame diverges at tick " << firstBadFrame << std::endl;
+	}
+	if (firstBadState >= 0 || firstBadFrame >= 0) {
+		return 1;
+	}
+	std::cout << "Every tick matches the recorded state" << (checkFrames ? " and frame" : "") << " hashes" << std::endl;
+	return 0;
+}
+
+//Tick and paint as fast as possible on this thread
+int benchFrames(PixelFormat format, int threads, int frames, int extraSprites, bool damaged) {
+	Game game;
+	game.background = background;
+	addSprites(game, extraSprites);
+	Renderer renderer(format, threads);
+	unsigned char* imageData = new unsigned char[renderer.getImageDataLength()];
+	std::vector<long long> frameNs(frames);
+	Damage damage;
+	long long damagedPixels = 0;
+	unsigned long long warmAllocations = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		if (frame == WARMUP_FRAMES) {
+			warmAllocations = getAllocationCount();
+		}
+
+		auto frameStart = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE("tick");
+			tick(game, scriptedInput(frame));
+			scrollView(game, frame);
+		}
+		PROFILE_SCOPE("paint");
+		if (damaged) {
+			renderer.findDamage(game, damage);
+			renderer.render(game, imageData, damage);
+			damagedPixels += damage.getPixelCount();
+		}
+		else {
+			renderer.render(game, imageData);
+		}
+		auto frameEnd = std::chrono::high_resolution_clock::now();
+		frameNs[frame] = std::chrono::duration_cast<std::chrono::nanoseconds>(frameEnd - frameStart).count();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	unsigned long long steadyAllocations = frames > WARMUP_FRAMES ? getAllocationCount() - warmAllocations : 0;
+
+	double totalSeconds = std::chrono::duration<double>(end - start).count();
+	std::sort(frameNs.begin(), frameNs.end());
+
+	std::cout << frames << " frames, " << game.sprites.size() << " sprites, " << threads << " threads" << std::endl;
+	std::cout << "frames/sec: " << frames / totalSeconds << std::endl;
+	std::cout << "ns/frame:   " << (long long)(totalSeconds * 1e9 / frames) << std::endl;
+	std::cout << "p50: " << percentile(frameNs, 0.50) << " ns, p95: " << percentile(frameNs, 0.95)
+		<< " ns, p99: " << percentile(frameNs, 0.99) << " ns, max: " << frameNs.back() << " ns" << std::endl;
+	if (damaged) {
+		std::cout << "damaged px/frame: " << damagedPixels / frames << std::endl;
+	}
+	std::cout << "heap allocations after warm-up: " << steadyAllocations << std::endl;
+
+	delete[] imageData;
+
+	return steadyAllocations > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+	int frames = 10000;
+	int extraSprites = 0;
+	bool compare = false;
+	bool spriteLayout = false;
+	bool damaged = false;
+	bool kernels = false;
+	bool checkThreadsOnly = false;
+	int threads = 1;
+	int pipelineDepth = 0;
+	const char* profilePath = NULL;
+	const char* replayPath = NULL;
+	const char* goldenPath = NULL;
+	const char* bmpPath = NULL;
+	const char* scenePath = NULL;
+	int sceneRepeat = 1;
+	bool updateGolden = false;
+	PixelFormat format = PixelFormat::Rgba;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) {
+			extraSprites = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--compare") == 0) {
+			compare = true;
+		}
+		else if (strcmp(argv[i], "--sprite-layout") == 0) {
+			spriteLayout = true;
+		}
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "indexed") == 0) {
+				format = PixelFormat::Indexed;
+			}
+			else if (strcmp(argv[i], "spectrum") == 0) {
+				format = PixelFormat::Spectrum;
+			}
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--check-threads") == 0) {
+			checkThreadsOnly = true;
+		}
+		else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+			pipelineDepth = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+			profilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+			goldenPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--update-golden") == 0 && i + 1 < argc) {
+			goldenPath = argv[++i];
+			updateGolden = true;
+		}
+		else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+			scenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--scroll") == 0 && i + 1 < argc) {
+			sceneRepeat = atoi(argv[++i]);
+			scrolling = true;
+		}
+		else if (strcmp(argv[i], "--load-bmp") == 0 && i + 1 < argc) {
+			bmpPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--kernels") == 0) {
+			kernels = true;
+		}
+		else if (strcmp(argv[i], "--damage") == 0) {
+			damaged = true;
+		}
+		else {
+			std::cout << "Usage: " << argv[0] << " " << USAGE;
+			return 1;
+		}
+	}
+
+	if (compare) {
+		compareSprites();
+		return 0;
+	}
+
+	if (spriteLayout) {
+		compareSpriteLayouts(std::min(frames, 1000));
+		return 0;
+	}
+
+	if (kernels) {
+		benchKernels();
+		return 0;
+	}
+
+	if (bmpPath != NULL) {
+		return benchLoadBmp(bmpPath);
+	}
+
+	if (goldenPath != NULL) {
+		return checkGoldenFrames(goldenPath, updateGolden);
+	}
+
+	if (frames < 1) {
+		frames = 1;
+	}
+
+	TileMap scene;
+	if (scenePath != NULL) {
+		if (!scene.load(scenePath, Palette(), sceneRepeat)) {
+			std::cout << "Could not read " << scenePath << std::endl;
+			return 1;
+		}
+		background = &scene;
+
+		int width = scene.getColumns() * TILE_SIZE;
+		int height = scene.getRows() * TILE_SIZE;
+		std::cout << scenePath << ": " << scene.getColumns() * scene.getRows() << " cells, " << scene.getTileSet().size()
+			<< " different tiles, " << scene.getByteCount() << " bytes as tiles against " << width * height
+			<< " as palette indices and " << width * height * 4 << " as RGBA" << std::endl;
+	}
+
+	if (checkThreadsOnly) {
+		return checkThreads(format, threads, frames, extraSprites);
+	}
+
+	Profiler::get().setEnabled(profilePath != NULL);
+
+	int result = 0;
+	if (replayPath != NULL) {
+		result = benchReplay(replayPath, format, threads);
+	}
+	else if (pipelineDepth > 0) {
+		result = benchPipeline(format, pipelineDepth, threads, frames, extraSprites);
+	}
+	else {
+		result = benchFrames(format, threads, frames, extraSprites, damaged);
+	}
+
+	if (profilePath != NULL) {
+		Profiler::get().writeChromeTrace(profilePath);
+		Profiler::get().printStats(std::cout);
+	}
+
+	return result;
+}
@@ -0,0 +1,209 @@
+#include "bmp.h"
+#include "kernels.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const size_t FILE_HEADER_SIZE = 14;
+static const size_t INFO_HEADER_SIZE = 40; //BITMAPINFOHEADER, the later versions only add fields after it
+static const unsigned int COMPRESSION_NONE = 0; //BI_RGB
+
+//BMP fields are little endian whatever the CPU is
+static unsigned int readU16(const unsigned char* bytes) {
+	return bytes[0] | bytes[1] << 8;
+}
+
+static unsigned int readU32(const unsigned char* bytes) {
+	return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (unsigned int)bytes[3] << 24;
+}
+
+BmpFile::~BmpFile() {
+	close();
+}
+
+bool BmpFile::open(const char* path) {
+	close();
+
+	if (!map(path) || !parseHeaders()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+#ifdef _WIN32
+bool BmpFile::map(const char* path) {
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return false;
+	}
+	length = (size_t)size.QuadPart;
+
+	mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL) {
+		return false;
+	}
+
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	return data != NULL;
+}
+
+void BmpFile::close() {
+	if (data != NULL) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != NULL) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != NULL) {
+		CloseHandle(fileHandle);
+	}
+
+	data = NULL;
+	mappingHandle = NULL;
+	fileHandle = NULL;
+	length = 0;
+	pixels = NULL;
+}
+#else
+bool BmpFile::map(const char* path) {
+	int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		::close(file);
+		return false;
+	}
+	length = (size_t)info.st_size;
+
+	//The mapping stays valid after the file is closed
+	void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	data = (const unsigned char*)mapping;
+	return true;
+}
+
+void BmpFile::close() {
+	if (data != NULL) {
+		munmap((void*)data, length);
+	}
+
+	data = NULL;
+	length = 0;
+	pixels = NULL;
+}
+#endif
+
+bool BmpFile::parseHeaders() {
+	if (length < FILE_HEADER_SIZE + INFO_HEADER_SIZE || data[0] != 'B' || data[1] != 'M') {
+		return false;
+	}
+
+	size_t pixelOffset = readU32(data + 10);
+	const unsigned char* info = data + FILE_HEADER_SIZE;
+	if (readU32(info) < INFO_HEADER_SIZE) {
+		return false;
+	}
+
+	int fileWidth = (int)readU32(info + 4);
+	int fileHeight = (int)readU32(info + 8);
+	bitsPerPixel = readU16(info + 14);
+	if (readU32(info + 16) != COMPRESSION_NONE || (bitsPerPixel != 24 && bitsPerPixel != 32)) {
+		return false;
+	}
+
+	//A negative height means the rows are stored top to bottom instead of the usual bottom to top
+	topDown = fileHeight < 0;
+	width = fileWidth;
+	height = topDown ? -fileHeight : fileHeight;
+	if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF) {
+		return false;
+	}
+
+	stride = (width * bitsPerPixel + 31) / 32 * 4;
+	if (pixelOffset > length || (size_t)stride * height > length - pixelOffset) {
+		return false;
+	}
+
+	pixels = data + pixelOffset;
+	return true;
+}
+
+const unsigned char* BmpFile::getRow(int y) const {
+	return pixels + (size_t)(topDown ? y : height - 1 - y) * stride;
+}
+
+void BmpFile::toRgba(unsigned char* target, int pitch) const {
+	for (int y = 0; y < height; y++) {
+		const unsigned char* row = getRow(y);
+		unsigned char* pixel = target + (size_t)y * pitch;
+
+		if (bitsPerPixel == 24) {
+			pixelKernels().bgrToRgba((uint32_t*)pixel, row, width);
+			continue;
+		}
+
+		//The fourth byte of 32 bit BMPs is unused without a BI_BITFIELDS alpha mask
+		for (int x = 0; x < width; x++) {
+			pixel[0] = row[2];
+			pixel[1] = row[1];
+			pixel[2] = row[0];
+			pixel[3] = 255;
+			pixel += 4;
+			row += 4;
+		}
+	}
+}
+
+void BmpFile::toIndexed(unsigned char* target, int pitch, const Palette& palette) const {
+	const int pixelSize = bitsPerPixel / 8;
+	//Pictures are mostly runs of the same colour, so remember the last match
+	int lastColor = -1;
+	unsigned char lastIndex = 0;
+
+	for (int y = 0; y < height; y++) {
+		const unsigned char* row = getRow(y);
+		unsigned char* index = target + (size_t)y * pitch;
+
+		for (int x = 0; x < width; x++) {
+			const unsigned char* pixel = row + x * pixelSize;
+			int color = pixel[0] | pixel[1] << 8 | pixel[2] << 16;
+
+			if (color != lastColor) {
+				int bestDistance = 0x7FFFFFFF;
+				for (int i = 0; i < PALETTE_SIZE; i++) {
+					int red = palette.colors[i][0] - pixel[2];
+					int green = palette.colors[i][1] - pixel[1];
+					int blue = palette.colors[i][2] - pixel[0];
+					int distance = red * red + green * green + blue * blue;
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						lastIndex = (unsigned char)i;
+					}
+				}
+				lastColor = color;
+			}
+
+			index[x] = lastIndex;
+		}
+	}
+}
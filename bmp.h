@@ -0,0 +1,49 @@
+#pragma once
+
+#include "palette.h"
+
+#include <cstddef>
+
+//A BMP file mapped straight into memory. Opening only reads the headers, and the conversions read the pixels from
+//the mapping into the caller's buffer, so no copy of the file is ever made
+class BmpFile {
+public:
+	BmpFile() {}
+	~BmpFile();
+
+	//False when the file can't be read or isn't an uncompressed 24 or 32 bit BMP
+	bool open(const char* path);
+	void close();
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getBitsPerPixel() const { return bitsPerPixel; }
+	bool isTopDown() const { return topDown; }
+
+	//Row y counting from the top, whichever way round the file stores them, in the file's own BGR or BGRX bytes
+	const unsigned char* getRow(int y) const;
+
+	//The whole picture as RGBA with full alpha, rows pitch bytes apart
+	void toRgba(unsigned char* target, int pitch) const;
+	//The whole picture as the index of the closest palette colour to every pixel, rows pitch bytes apart
+	void toIndexed(unsigned char* target, int pitch, const Palette& palette) const;
+
+private:
+	BmpFile(const BmpFile&) = delete;
+	BmpFile& operator=(const BmpFile&) = delete;
+
+	bool map(const char* path);
+	bool parseHeaders();
+
+	const unsigned char* data = NULL;
+	size_t length = 0;
+	void* fileHandle = NULL; //Windows only, the mapping keeps its own
+	void* mappingHandle = NULL;
+
+	const unsigned char* pixels = NULL; //Where the rows start, at the offset the file header gives
+	int width = 0;
+	int height = 0;
+	int bitsPerPixel = 0;
+	int stride = 0; //Bytes per row including the padding up to a multiple of 4
+	bool topDown = false;
+};
@@ -0,0 +1,90 @@
+#include "damage.h"
+#include "game.h"
+
+#include <algorithm>
+
+const int Damage::FULL_SCREEN_THRESHOLD = SCREEN_WIDTH * SCREEN_HEIGHT / 2;
+
+static bool touches(const Rect& a, const Rect& b) {
+	return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+void Damage::clear() {
+	rects.clear();
+	fullScreen = false;
+}
+
+void Damage::add(Rect rect) {
+	if (fullScreen) {
+		return;
+	}
+
+	//Clip to the screen
+	if (rect.x < 0) {
+		rect.width += rect.x;
+		rect.x = 0;
+	}
+	if (rect.y < 0) {
+		rect.height += rect.y;
+		rect.y = 0;
+	}
+	if (rect.x + rect.width > (int)SCREEN_WIDTH) {
+		rect.width = SCREEN_WIDTH - rect.x;
+	}
+	if (rect.y + rect.height > (int)SCREEN_HEIGHT) {
+		rect.height = SCREEN_HEIGHT - rect.y;
+	}
+	if (rect.width <= 0 || rect.height <= 0) {
+		return;
+	}
+
+	//Grow the new rectangle over everything it touches, so the list never holds overlapping rectangles
+	size_t i = 0;
+	while (i < rects.size()) {
+		if (touches(rect, rects[i])) {
+			int right = std::max(rect.x + rect.width, rects[i].x + rects[i].width);
+			int bottom = std::max(rect.y + rect.height, rects[i].y + rects[i].height);
+			rect.x = std::min(rect.x, rects[i].x);
+			rect.y = std::min(rect.y, rects[i].y);
+			rect.width = right - rect.x;
+			rect.height = bottom - rect.y;
+
+			rects[i] = rects.back();
+			rects.pop_back();
+			i = 0;
+		}
+		else {
+			i++;
+		}
+	}
+
+	//One rectangle more than fits means the damage is spread too thin to be worth tracking
+	if (!rects.push_back(rect) || getPixelCount() > FULL_SCREEN_THRESHOLD) {
+		addScreen();
+	}
+}
+
+void Damage::addAll(const Damage& other) {
+	if (other.fullScreen) {
+		addScreen();
+		return;
+	}
+
+	for (auto const& rect : other.rects) {
+		add(rect);
+	}
+}
+
+void Damage::addScreen() {
+	rects.clear();
+	rects.push_back({ 0, 0, (int)SCREEN_WIDTH, (int)SCREEN_HEIGHT });
+	fullScreen = true;
+}
+
+int Damage::getPixelCount() const {
+	int count = 0;
+	for (auto const& rect : rects) {
+		count += rect.width * rect.height;
+	}
+	return count;
+}
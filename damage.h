@@ -0,0 +1,31 @@
+#pragma once
+
+#include "fixedvector.h"
+
+struct Rect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+//The parts of the screen that changed since some earlier frame. Overlapping rectangles are merged as they are added,
+//and once too much of the screen is covered the whole thing becomes one full screen rectangle
+class Damage {
+public:
+	static const int MAX_RECTS = 32;
+	static const int FULL_SCREEN_THRESHOLD; //Damaged pixel count above which repainting everything is cheaper
+
+	void clear();
+	void add(Rect rect);
+	void addAll(const Damage& other);
+	void addScreen();
+
+	bool isEmpty() const { return rects.empty(); }
+	int getPixelCount() const;
+	const FixedVector<Rect, MAX_RECTS>& getRects() const { return rects; }
+
+private:
+	FixedVector<Rect, MAX_RECTS> rects;
+	bool fullScreen = false;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+//A vector with room for Capacity elements inside it, so filling and clearing it never touches the heap
+template <typename T, size_t Capacity>
+class FixedVector {
+public:
+	static const size_t CAPACITY = Capacity;
+
+	//Returns false instead of growing when it is full
+	bool push_back(const T& value) {
+		if (count == Capacity) {
+			return false;
+		}
+		items[count++] = value;
+		return true;
+	}
+
+	void pop_back() { count--; }
+	void clear() { count = 0; }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	bool full() const { return count == Capacity; }
+
+	T& operator[](size_t i) { return items[i]; }
+	const T& operator[](size_t i) const { return items[i]; }
+	T& back() { return items[count - 1]; }
+	const T& back() const { return items[count - 1]; }
+
+	T* begin() { return items; }
+	T* end() { return items + count; }
+	const T* begin() const { return items; }
+	const T* end() const { return items + count; }
+
+private:
+	T items[Capacity];
+	size_t count = 0;
+};
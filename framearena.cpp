@@ -0,0 +1,48 @@
+#include "framearena.h"
+
+#include <cstdint>
+
+//Enough for any type the arena hands out
+static const size_t BLOCK_ALIGNMENT = 16;
+
+FrameArena::FrameArena(size_t capacity) : block(NULL), capacity(0) {
+	if (capacity > 0) {
+		block = new unsigned char[capacity + BLOCK_ALIGNMENT];
+		this->capacity = capacity;
+	}
+}
+
+FrameArena::~FrameArena() {
+	reset();
+	delete[] block;
+}
+
+void FrameArena::reset() {
+	for (auto const& allocation : overflow) {
+		delete[] allocation;
+	}
+	overflow.clear();
+
+	//Grow to what the last frame needed, with some headroom so a frame slightly bigger than the last doesn't overflow again
+	if (used > capacity) {
+		delete[] block;
+		capacity = used + used / 2;
+		block = new unsigned char[capacity + BLOCK_ALIGNMENT];
+	}
+	used = 0;
+}
+
+void* FrameArena::allocateBytes(size_t size, size_t alignment) {
+	//Counted as used even when it doesn't fit, which is what tells reset() how big the block needs to be
+	size_t start = (used + alignment - 1) & ~(alignment - 1);
+	used = start + size;
+
+	if (used <= capacity) {
+		unsigned char* base = (unsigned char*)(((uintptr_t)block + BLOCK_ALIGNMENT - 1) & ~(uintptr_t)(BLOCK_ALIGNMENT - 1));
+		return base + start;
+	}
+
+	unsigned char* allocation = new unsigned char[size + BLOCK_ALIGNMENT];
+	overflow.push_back(allocation);
+	return (void*)(((uintptr_t)allocation + BLOCK_ALIGNMENT - 1) & ~(uintptr_t)(BLOCK_ALIGNMENT - 1));
+}
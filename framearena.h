@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+//Memory for data that only lives during one frame. Allocating bumps a pointer and reset() takes everything back at once.
+//Running out never fails, the allocation falls back to the heap and the next reset() grows the block to fit the
+//whole frame, so once the frames stop getting bigger nothing is allocated at all
+class FrameArena {
+public:
+	FrameArena(size_t capacity = 0);
+	~FrameArena();
+
+	//Room for count Ts, left uninitialised. Only for types that need no destructor, none is ever run
+	template <typename T>
+	T* allocate(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+		return (T*)allocateBytes(count * sizeof(T), alignof(T));
+	}
+
+	//Everything allocated since the last reset() becomes invalid
+	void reset();
+
+private:
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocateBytes(size_t size, size_t alignment);
+
+	unsigned char* block;
+	size_t capacity;
+	size_t used = 0;
+	std::vector<unsigned char*> overflow; //Heap fallbacks since the last reset()
+};
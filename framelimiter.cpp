@@ -0,0 +1,62 @@
+#include "framelimiter.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+const std::chrono::microseconds FrameLimiter::SPIN_TIME(2000);
+
+FrameLimiter::FrameLimiter(double targetFps) : targetFps(0.0), frameLength(0) {
+#ifdef _WIN32
+	//Sleeps are rounded up to the 15.6ms scheduler tick otherwise, longer than a whole 60fps frame
+	timeBeginPeriod(1);
+#endif
+	setTargetFps(targetFps);
+}
+
+FrameLimiter::~FrameLimiter() {
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FrameLimiter::setTargetFps(double targetFps) {
+	this->targetFps = targetFps > 0.0 ? targetFps : 0.0;
+	frameLength = this->targetFps > 0.0
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / this->targetFps))
+		: Clock::duration(0);
+	nextFrame = Clock::now() + frameLength;
+}
+
+void FrameLimiter::wait() {
+	if (targetFps == 0.0) {
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+
+	//More than a frame late, start counting again from now instead of rushing out frames to catch up
+	if (now > nextFrame + frameLength) {
+		nextFrame = now;
+	}
+
+	sleepUntil(nextFrame);
+	nextFrame += frameLength;
+}
+
+void FrameLimiter::sleepFor(double seconds) {
+	sleepUntil(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)));
+}
+
+void FrameLimiter::sleepUntil(Clock::time_point deadline) {
+	Clock::time_point now = Clock::now();
+	if (deadline - now > SPIN_TIME) {
+		std::this_thread::sleep_for(deadline - now - SPIN_TIME);
+	}
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
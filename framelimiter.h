@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+
+//Holds frames to a target rate when vsync is off or slower than wanted. Most of the wait is a sleep, which the OS
+//may oversleep, so the last stretch before the deadline is spent yielding in a loop instead
+class FrameLimiter {
+public:
+	static const std::chrono::microseconds SPIN_TIME; //How long before the deadline to stop sleeping
+
+	FrameLimiter(double targetFps = 0.0);
+	~FrameLimiter();
+
+	//0 turns the limiter off
+	void setTargetFps(double targetFps);
+	double getTargetFps() const { return targetFps; }
+
+	//Wait until the next frame is due
+	void wait();
+
+	//The same sleep then spin, for other waits that need to end on time
+	static void sleepFor(double seconds);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	static void sleepUntil(Clock::time_point deadline);
+
+	double targetFps;
+	Clock::duration frameLength;
+	Clock::time_point nextFrame;
+};
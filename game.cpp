@@ -0,0 +1,55 @@
+#include "game.h"
+
+#include <cmath>
+
+Game::Game() {
+	player = sprites.add(24, 8);
+}
+
+void tick(Game& game, const Input& input) {
+	size_t testSprite = game.sprites.indexOf(game.player);
+	if (testSprite == SpriteStore::NOT_FOUND) {
+		return;
+	}
+
+	if (input.up) {
+		game.sprites.y[testSprite] -= 1;
+	}
+
+	if (input.down) {
+		game.sprites.y[testSprite] += 1;
+	}
+
+	if (input.left) {
+		game.sprites.x[testSprite] -= 1;
+	}
+
+	if (input.right) {
+		game.sprites.x[testSprite] += 1;
+	}
+}
+
+void interpolate(const Game& previous, const Game& current, double alpha, Game& result) {
+	result = current;
+
+	//Usually nothing was added or removed and every sprite is at the same index in both,
+	//otherwise find each one by its handle. Sprites added this tick have nothing to blend with
+	bool sameOrder = previous.sprites.getHandles() == current.sprites.getHandles();
+	const std::vector<SpriteHandle>& handles = current.sprites.getHandles();
+
+	for (size_t i = 0; i < current.sprites.size(); i++) {
+		size_t from = sameOrder ? i : previous.sprites.indexOf(handles[i]);
+		if (from == SpriteStore::NOT_FOUND) {
+			continue;
+		}
+
+		//Positions wrap around, so take the short way between them
+		signed char dx = (signed char)(current.sprites.x[i] - previous.sprites.x[from]);
+		signed char dy = (signed char)(current.sprites.y[i] - previous.sprites.y[from]);
+		result.sprites.x[i] = (unsigned char)(previous.sprites.x[from] + (int)floor(dx * alpha + 0.5));
+		result.sprites.y[i] = (unsigned char)(previous.sprites.y[from] + (int)floor(dy * alpha + 0.5));
+	}
+
+	result.scrollX = previous.scrollX + (int)floor((current.scrollX - previous.scrollX) * alpha + 0.5);
+	result.scrollY = previous.scrollY + (int)floor((current.scrollY - previous.scrollY) * alpha + 0.5);
+}
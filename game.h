@@ -0,0 +1,43 @@
+#pragma once
+
+#include "palette.h"
+#include "spritestore.h"
+#include "tilemap.h"
+
+#include <cstddef>
+#include <vector>
+
+// settings
+static const unsigned int SCREEN_WIDTH = 128;
+static const unsigned int SCREEN_HEIGHT = 72;
+
+//The directions being held down for a tick
+struct Input {
+	bool left = false;
+	bool right = false;
+	bool up = false;
+	bool down = false;
+
+	bool operator==(const Input& other) const {
+		return left == other.left && right == other.right && up == other.up && down == other.down;
+	}
+	bool operator!=(const Input& other) const { return !(*this == other); }
+};
+
+//Everything the simulation needs, kept away from the window and GL so it can run headless
+struct Game {
+	SpriteStore sprites;
+	SpriteHandle player; //The sprite the player moves around
+	Palette palette;
+	const TileMap* background = NULL; //Drawn behind the sprites instead of black, owned by whoever loaded it
+	//Background pixel at the top left of the screen. Anywhere is allowed, past the edges of the map is black
+	int scrollX = 0;
+	int scrollY = 0;
+
+	Game();
+};
+
+void tick(Game& game, const Input& input);
+
+//Blend sprite positions and the scroll between two ticks for drawing, alpha 0 being previous and 1 being current
+void interpolate(const Game& previous, const Game& current, double alpha, Game& result);
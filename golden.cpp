@@ -0,0 +1,297 @@
+#include "golden.h"
+#include "renderer.h"
+#include "tilemap.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct GoldenScene {
+	const char* name;
+	void (*setup)(Game& game);
+	int background = 0; //Drawn over the tiles of the test scene, repeated this many times each way
+};
+
+static void addSprite(Game& game, int x, int y) {
+	game.sprites.add((unsigned char)x, (unsigned char)y);
+}
+
+static const GoldenScene SCENES[] = {
+	{ "start", [](Game&) {
+	} },
+	//Sprites touching every edge, and half off every edge
+	{ "edges", [](Game& game) {
+		addSprite(game, 8, 8);
+		addSprite(game, SCREEN_WIDTH - 1, 8);
+		addSprite(game, 8, SCREEN_HEIGHT - 1);
+		addSprite(game, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
+		addSprite(game, 0, 0);
+		addSprite(game, 4, 40);
+		addSprite(game, SCREEN_WIDTH + 3, 40);
+		addSprite(game, 64, 4);
+		addSprite(game, 64, SCREEN_HEIGHT + 3);
+	} },
+	//The player walked off the left and top edges, so x and y wrapped round to the far end of unsigned char
+	{ "wraparound", [](Game& game) {
+		Input left;
+		left.left = true;
+		Input up;
+		up.up = true;
+		for (int i = 0; i < 30; i++) {
+			tick(game, left);
+		}
+		for (int i = 0; i < 12; i++) {
+			tick(game, up);
+		}
+		addSprite(game, 255, 255);
+		addSprite(game, 255, 30);
+		addSprite(game, 40, 255);
+		addSprite(game, 2, 2);
+	} },
+	//A pile of overlapping sprites, also past the right and bottom edges
+	{ "overlap", [](Game& game) {
+		unsigned int seed = 12345;
+		for (int i = 0; i < 300; i++) {
+			seed = seed * 1103515245 + 12345;
+			int x = (seed >> 16) % (SCREEN_WIDTH + 16);
+			seed = seed * 1103515245 + 12345;
+			int y = (seed >> 16) % (SCREEN_HEIGHT + 16);
+			addSprite(game, x, y);
+		}
+	} },
+	//Many sprites on one row, some stacked exactly on top of each other
+	{ "crowdedrow", [](Game& game) {
+		for (int i = 0; i < 60; i++) {
+			addSprite(game, (i * 5) % (SCREEN_WIDTH + 8), 36);
+		}
+	} },
+	//Sprites over the tiles, in the middle of cells and across cell and tile edges
+	{ "background", [](Game& game) {
+		addSprite(game, 20, 20);
+		addSprite(game, 44, 12);
+		addSprite(game, 100, 60);
+		addSprite(game, SCREEN_WIDTH + 3, 40);
+	}, 1 },
+	//Scrolled into a map three screens each way, part way into a tile both ways and far enough that the window wraps
+	{ "scrolled", [](Game& game) {
+		game.scrollX = 133;
+		game.scrollY = 43;
+		addSprite(game, 20, 20);
+		addSprite(game, 61, 35);
+	}, 3 },
+	//RGBA has the palette baked into the pixels, the other formats look it up afterwards. Spectrum cells the sprites
+	//touch have bright black paper, so both blacks change to keep one picture for every format
+	{ "palette", [](Game& game) {
+		game.palette.set(PALETTE_BLACK, 0, 0, 96);
+		game.palette.set(PALETTE_BRIGHT + PALETTE_BLACK, 0, 0, 96);
+		game.palette.set(PALETTE_BRIGHT + PALETTE_GREEN, 255, 128, 0);
+		addSprite(game, 80, 50);
+	} }
+};
+
+static const int PIXELS = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+//Turn any format into the RGB the fragment shader would show
+static void decodeToRgb(PixelFormat format, const unsigned char* imageData, const Palette& palette, std::vector<unsigned char>& rgb) {
+	rgb.resize(PIXELS * 3);
+
+	for (int y = 0; y < (int)SCREEN_HEIGHT; y++) {
+		for (int x = 0; x < (int)SCREEN_WIDTH; x++) {
+			const unsigned char* color = NULL;
+			int pixel = y * SCREEN_WIDTH + x;
+
+			switch (format) {
+			case PixelFormat::Rgba:
+				color = imageData + pixel * 4;
+				break;
+			case PixelFormat::Indexed:
+				color = palette.colors[imageData[pixel]];
+				break;
+			case PixelFormat::Spectrum: {
+				int bits = imageData[y * (SCREEN_WIDTH / 8) + x / 8];
+				int attributes = imageData[SPECTRUM_BITMAP_LENGTH + (y / 8) * (SCREEN_WIDTH / 8) + x / 8];
+				bool ink = ((bits >> (7 - x % 8)) & 1) != 0;
+				int index = (ink ? attributes : attributes >> 3) & 7;
+				color = palette.colors[(attributes & 64) != 0 ? index + 8 : index];
+				break;
+			}
+			}
+
+			rgb[pixel * 3] = color[0];
+			rgb[pixel * 3 + 1] = color[1];
+			rgb[pixel * 3 + 2] = color[2];
+		}
+	}
+}
+
+static bool writePpm(const std::string& path, const std::vector<unsigned char>& rgb) {
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", (int)SCREEN_WIDTH, (int)SCREEN_HEIGHT);
+	bool written = fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+	return fclose(file) == 0 && written;
+}
+
+static bool readPpm(const std::string& path, std::vector<unsigned char>& rgb) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	int maxValue = 0;
+	bool valid = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && fgetc(file) != EOF
+		&& width == (int)SCREEN_WIDTH && height == (int)SCREEN_HEIGHT && maxValue == 255;
+	if (valid) {
+		rgb.resize(PIXELS * 3);
+		valid = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+	}
+
+	fclose(file);
+	return valid;
+}
+
+//Differing pixels in red over a darkened copy of the expected picture
+static std::vector<unsigned char> diffImage(const std::vector<unsigned char>& expected, const std::vector<unsigned char>& actual, int& differing) {
+	std::vector<unsigned char> diff(PIXELS * 3);
+	differing = 0;
+
+	for (int pixel = 0; pixel < PIXELS; pixel++) {
+		const unsigned char* a = &expected[pixel * 3];
+		const unsigned char* b = &actual[pixel * 3];
+		if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2]) {
+			diff[pixel * 3] = 255;
+			diff[pixel * 3 + 1] = 0;
+			diff[pixel * 3 + 2] = 0;
+			differing++;
+		}
+		else {
+			for (int i = 0; i < 3; i++) {
+				diff[pixel * 3 + i] = a[i] / 4;
+			}
+		}
+	}
+
+	return diff;
+}
+
+//Spectrum attributes can't show every colour of a tile, so scenes with a background get a picture of their own for it
+static std::string goldenPath(const char* directory, const GoldenScene& scene, PixelFormat format) {
+	bool ownPicture = scene.background > 0 && format == PixelFormat::Spectrum;
+	return std::string(directory) + "/" + scene.name + (ownPicture ? "-spectrum" : "") + ".ppm";
+}
+
+int checkGoldenFrames(const char* directory, bool update) {
+	const PixelFormat formats[] = { PixelFormat::Rgba, PixelFormat::Indexed, PixelFormat::Spectrum };
+	const char* formatNames[] = { "rgba", "indexed", "spectrum" };
+	const int threadCounts[] = { 1, 4 };
+
+	int checked = 0;
+	int failed = 0;
+
+	//The game's own test scene, so the goldens show what it draws
+	std::string backgroundPath = std::string(directory) + "/../testscene.bmp";
+	TileMap backgrounds[3];
+	bool backgroundLoaded = true;
+	for (int i = 0; i < 3; i++) {
+		backgroundLoaded = backgroundLoaded && backgrounds[i].load(backgroundPath.c_str(), Palette(), i + 1);
+	}
+
+	for (auto const& scene : SCENES) {
+		Game game;
+		scene.setup(game);
+		if (scene.background > 0) {
+			if (!backgroundLoaded) {
+				std::cout << "Could not read " << backgroundPath << std::endl;
+				failed++;
+				continue;
+			}
+			game.background = &backgrounds[scene.background - 1];
+		}
+
+		if (update) {
+			for (int f = 0; f < 3; f++) {
+				std::string path = goldenPath(directory, scene, formats[f]);
+				if (f > 0 && path == goldenPath(directory, scene, PixelFormat::Rgba)) {
+					continue;
+				}
+
+				Renderer renderer(formats[f]);
+				std::vector<unsigned char> imageData(renderer.getImageDataLength());
+				std::vector<unsigned char> rgb;
+				renderer.render(game, imageData.data());
+				decodeToRgb(formats[f], imageData.data(), game.palette, rgb);
+				if (!writePpm(path, rgb)) {
+					std::cout << "Could not write " << path << std::endl;
+					return 1;
+				}
+				std::cout << "Wrote " << path << std::endl;
+			}
+			continue;
+		}
+
+		//The same scene with every sprite moved and the view scrolled, painted first so the damaged repaint has something
+		//to fix up and the tiles that scroll in on the way have to be decoded
+		Game moved = game;
+		for (size_t i = 0; i < moved.sprites.size(); i++) {
+			moved.sprites.x[i] += 3;
+			moved.sprites.y[i] += 2;
+		}
+		moved.scrollX -= 13;
+		moved.scrollY -= 6;
+
+		for (int f = 0; f < 3; f++) {
+			std::string path = goldenPath(directory, scene, formats[f]);
+			std::vector<unsigned char> expected;
+			if (!readPpm(path, expected)) {
+				std::cout << "Could not read " << path << std::endl;
+				failed++;
+				continue;
+			}
+
+			for (int threads : threadCounts) {
+				for (int damaged = 0; damaged < 2; damaged++) {
+					Renderer renderer(formats[f], threads);
+					std::vector<unsigned char> imageData(renderer.getImageDataLength());
+
+					if (damaged) {
+						Damage damage;
+						renderer.findDamage(moved, damage);
+						renderer.render(moved, imageData.data());
+						renderer.findDamage(game, damage);
+						renderer.render(game, imageData.data(), damage);
+					}
+					else {
+						renderer.render(game, imageData.data());
+					}
+
+					std::vector<unsigned char> actual;
+					decodeToRgb(formats[f], imageData.data(), game.palette, actual);
+					checked++;
+
+					if (actual == expected) {
+						continue;
+					}
+
+					std::string variant = std::string(scene.name) + "-" + formatNames[f] + "-" + std::to_string(threads) + (damaged ? "-damage" : "-full");
+					//In the working directory, so a failing run doesn't leave files among the goldens
+					std::string base = variant;
+					int differing = 0;
+					writePpm(base + ".actual.ppm", actual);
+					writePpm(base + ".diff.ppm", diffImage(expected, actual, differing));
+					std::cout << variant << ": " << differing << " pixels differ, see " << base << ".diff.ppm" << std::endl;
+					failed++;
+				}
+			}
+		}
+	}
+
+	if (!update) {
+		std::cout << checked - failed << " of " << checked << " golden frames match" << std::endl;
+	}
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+//Paints a set of fixed scenes in every pixel format, with one and several threads, both in full and through damage
+//repaints, and compares each picture with the images stored in directory. A mismatch writes the picture it got and
+//a diff image to the working directory. Scenes with a background draw testscene.bmp from the directory above. update
+//writes the images instead, from single threaded full RGBA renders, plus a Spectrum one for scenes with a background
+//since its attribute cells can't show every tile colour
+int checkGoldenFrames(const char* directory, bool update);
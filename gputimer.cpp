@@ -0,0 +1,71 @@
+#include "gputimer.h"
+#include "profiler.h"
+
+static const char* STAGE_NAMES[GpuTimer::STAGE_COUNT] = { "gpu upload", "gpu draw" };
+
+GpuTimer::GpuTimer() : current(0), samples(0), dropped(0) {
+	glGenQueries(RING_SIZE * STAGE_COUNT * 2, &queries[0][0][0]);
+	for (int i = 0; i < RING_SIZE; i++) {
+		issued[i] = false;
+	}
+	resetStats();
+
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	clockOffset = (long long)Profiler::now() - gpuNow;
+}
+
+GpuTimer::~GpuTimer() {
+	glDeleteQueries(RING_SIZE * STAGE_COUNT * 2, &queries[0][0][0]);
+}
+
+void GpuTimer::beginFrame() {
+	current = (current + 1) % RING_SIZE;
+	if (issued[current]) {
+		collect(current);
+		issued[current] = false;
+	}
+}
+
+void GpuTimer::start(Stage stage) {
+	glQueryCounter(queries[current][stage][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::stop(Stage stage) {
+	glQueryCounter(queries[current][stage][1], GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame() {
+	issued[current] = true;
+}
+
+void GpuTimer::resetStats() {
+	samples = 0;
+	dropped = 0;
+	for (int stage = 0; stage < STAGE_COUNT; stage++) {
+		totalNs[stage] = 0.0;
+	}
+}
+
+void GpuTimer::collect(int slot) {
+	//The last stage's stop is the last timestamp the GPU writes, once it's there the rest are too
+	GLint available = 0;
+	glGetQueryObjectiv(queries[slot][STAGE_COUNT - 1][1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		dropped++;
+		return;
+	}
+
+	for (int stage = 0; stage < STAGE_COUNT; stage++) {
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(queries[slot][stage][0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(queries[slot][stage][1], GL_QUERY_RESULT, &end);
+		totalNs[stage] += (double)(end - start);
+
+		if (Profiler::get().isEnabled()) {
+			Profiler::get().record(STAGE_NAMES[stage], start + clockOffset, end + clockOffset, Profiler::GPU_LANE);
+		}
+	}
+	samples++;
+}
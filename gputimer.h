@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//Times how long the GPU spends on each stage of a frame with GL_TIMESTAMP queries. CPU timers around GL calls only
+//see how long it took to queue them. Results are read back RING_SIZE frames later, and only if they are ready,
+//so asking never makes the CPU wait for the GPU
+class GpuTimer {
+public:
+	static const int RING_SIZE = 4;
+
+	enum Stage {
+		STAGE_UPLOAD,
+		STAGE_DRAW,
+		STAGE_COUNT
+	};
+
+	GpuTimer();
+	~GpuTimer();
+
+	//Call before the first stage of a frame, collects whatever finished since this slot was last used
+	void beginFrame();
+	//Timestamp pairs around the GL calls of a stage, every stage once per frame
+	void start(Stage stage);
+	void stop(Stage stage);
+	void endFrame();
+
+	//Totals over the frames collected since resetStats()
+	int getSamples() const { return samples; }
+	double getAverageMs(Stage stage) const { return samples > 0 ? totalNs[stage] / 1e6 / samples : 0.0; }
+	int getDropped() const { return dropped; }
+	void resetStats();
+
+private:
+	void collect(int slot);
+
+	unsigned int queries[RING_SIZE][STAGE_COUNT][2]; //Start and stop timestamps
+	bool issued[RING_SIZE];
+	int current;
+
+	long long clockOffset; //Added to GPU timestamps to line them up with the profiler's clock
+
+	int samples;
+	double totalNs[STAGE_COUNT];
+	int dropped; //Frames whose results still weren't ready when their slot came round again
+};
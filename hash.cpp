@@ -0,0 +1,114 @@
+#include "hash.h"
+
+#include <cstring>
+
+static const unsigned long long PRIME1 = 11400714785074694791ull;
+static const unsigned long long PRIME2 = 14029467366897019727ull;
+static const unsigned long long PRIME3 = 1609587929392839161ull;
+static const unsigned long long PRIME4 = 9650029242287828579ull;
+static const unsigned long long PRIME5 = 2870177450012600261ull;
+
+static inline unsigned long long rotateLeft(unsigned long long value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+//Little endian reads, whatever the alignment
+static inline unsigned long long read64(const unsigned char* p) {
+	unsigned long long value;
+	memcpy(&value, p, 8);
+	return value;
+}
+
+static inline unsigned int read32(const unsigned char* p) {
+	unsigned int value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static inline unsigned long long accumulate(unsigned long long accumulator, unsigned long long input) {
+	accumulator += input * PRIME2;
+	accumulator = rotateLeft(accumulator, 31);
+	return accumulator * PRIME1;
+}
+
+static inline unsigned long long mergeRound(unsigned long long hash, unsigned long long accumulator) {
+	hash ^= accumulate(0, accumulator);
+	return hash * PRIME1 + PRIME4;
+}
+
+unsigned long long hashBytes(const void* data, size_t length, unsigned long long seed) {
+	const unsigned char* p = (const unsigned char*)data;
+	const unsigned char* end = p + length;
+	unsigned long long hash;
+
+	//Four independent lanes over 32 byte stripes
+	if (length >= 32) {
+		unsigned long long v1 = seed + PRIME1 + PRIME2;
+		unsigned long long v2 = seed + PRIME2;
+		unsigned long long v3 = seed;
+		unsigned long long v4 = seed - PRIME1;
+
+		const unsigned char* limit = end - 32;
+		do {
+			v1 = accumulate(v1, read64(p));
+			v2 = accumulate(v2, read64(p + 8));
+			v3 = accumulate(v3, read64(p + 16));
+			v4 = accumulate(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+		hash = mergeRound(hash, v1);
+		hash = mergeRound(hash, v2);
+		hash = mergeRound(hash, v3);
+		hash = mergeRound(hash, v4);
+	}
+	else {
+		hash = seed + PRIME5;
+	}
+
+	hash += length;
+
+	while (p + 8 <= end) {
+		hash ^= accumulate(0, read64(p));
+		hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+		p += 8;
+	}
+	if (p + 4 <= end) {
+		hash ^= read32(p) * PRIME1;
+		hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	while (p < end) {
+		hash ^= *p * PRIME5;
+		hash = rotateLeft(hash, 11) * PRIME1;
+		p++;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+unsigned long long hashGame(const Game& game) {
+	//Palette version is only a change counter, the colours are what matter
+	const SpriteStore& sprites = game.sprites;
+	unsigned long long hash = hashBytes(game.palette.colors, sizeof(game.palette.colors), sprites.indexOf(game.player));
+	hash = hashBytes(sprites.getHandles().data(), sprites.size() * sizeof(SpriteHandle), hash);
+	hash = hashBytes(sprites.x.data(), sprites.size(), hash);
+	hash = hashBytes(sprites.y.data(), sprites.size(), hash);
+	hash = hashBytes(sprites.width.data(), sprites.size(), hash);
+	hash = hashBytes(sprites.height.data(), sprites.size(), hash);
+	hash = hashBytes(sprites.image.data(), sprites.size(), hash);
+	hash = hashBytes(sprites.flags.data(), sprites.size(), hash);
+
+	//A view that never scrolled hashes the same as before there was scrolling, so older recordings still check out
+	if (game.scrollX != 0 || game.scrollY != 0) {
+		int scroll[] = { game.scrollX, game.scrollY };
+		hash = hashBytes(scroll, sizeof(scroll), hash);
+	}
+	return hash;
+}
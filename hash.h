@@ -0,0 +1,11 @@
+#pragma once
+
+#include "game.h"
+
+#include <cstddef>
+
+//64 bit xxHash (XXH64). Several GB/s, so hashing every tick and frame costs next to nothing
+unsigned long long hashBytes(const void* data, size_t length, unsigned long long seed = 0);
+
+//Everything tick() reads or writes
+unsigned long long hashGame(const Game& game);
@@ -0,0 +1,71 @@
+#include "input.h"
+
+InputQueue::InputQueue() : events(CAPACITY), hasNext(false), oldestEventTime(0) {
+	for (int i = 0; i < (int)Action::Count; i++) {
+		held[i] = false;
+		tapped[i] = false;
+	}
+}
+
+bool InputQueue::push(const InputEvent& event) {
+	InputEvent copy = event;
+	return events.push(std::move(copy));
+}
+
+void InputQueue::pushChanges(const Input& from, const Input& to, unsigned long long time) {
+	const bool before[] = { from.left, from.right, from.up, from.down };
+	const bool after[] = { to.left, to.right, to.up, to.down };
+
+	for (int i = 0; i < (int)Action::Count; i++) {
+		if (before[i] != after[i]) {
+			InputEvent event;
+			event.time = time;
+			event.action = (Action)i;
+			event.pressed = after[i];
+			push(event);
+		}
+	}
+}
+
+Input InputQueue::takeTick(unsigned long long time) {
+	oldestEventTime = 0;
+
+	while (hasNext || events.pop(next)) {
+		if (next.time > time) {
+			hasNext = true;
+			break;
+		}
+		hasNext = false;
+
+		if (oldestEventTime == 0) {
+			oldestEventTime = next.time;
+		}
+
+		int action = (int)next.action;
+		held[action] = next.pressed;
+		if (next.pressed) {
+			tapped[action] = true;
+		}
+	}
+
+	Input input;
+	input.left = held[(int)Action::Left] || tapped[(int)Action::Left];
+	input.right = held[(int)Action::Right] || tapped[(int)Action::Right];
+	input.up = held[(int)Action::Up] || tapped[(int)Action::Up];
+	input.down = held[(int)Action::Down] || tapped[(int)Action::Down];
+
+	for (int i = 0; i < (int)Action::Count; i++) {
+		tapped[i] = false;
+	}
+
+	return input;
+}
+
+bool InputQueue::isAnyHeld() const {
+	for (int i = 0; i < (int)Action::Count; i++) {
+		if (held[i]) {
+			return true;
+		}
+	}
+	return false;
+}
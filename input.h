@@ -0,0 +1,51 @@
+#pragma once
+
+#include "game.h"
+#include "spscqueue.h"
+
+//What a key can be bound to in the game
+enum class Action : unsigned char {
+	Left,
+	Right,
+	Up,
+	Down,
+	Count
+};
+
+//A bound key going down or up. Time is Profiler::now() when the window system handed it to us
+struct InputEvent {
+	unsigned long long time;
+	Action action;
+	bool pressed;
+};
+
+//Carries key events from the window thread to whichever thread ticks the game, and turns them into an Input
+//per tick. A key pressed and released again between two ticks still counts as held for one, so short taps
+//aren't lost the way they were when keys were polled once a frame
+class InputQueue {
+public:
+	static const int CAPACITY = 256;
+
+	InputQueue();
+
+	//Window thread. Returns false and drops the event when the simulation has fallen this far behind
+	bool push(const InputEvent& event);
+	//Push whatever differs between two inputs, for scripted and replayed input
+	void pushChanges(const Input& from, const Input& to, unsigned long long time);
+
+	//Simulation thread. Apply every event up to time and return the input for a tick at that time
+	Input takeTick(unsigned long long time);
+	//Oldest event the last takeTick() applied, 0 if there were none
+	unsigned long long getOldestEventTime() const { return oldestEventTime; }
+	//Keys down right now, as far as the events taken so far go
+	bool isAnyHeld() const;
+
+private:
+	SpscQueue<InputEvent> events;
+	InputEvent next; //Popped but after the tick being taken, it goes into a later one
+	bool hasNext;
+
+	bool held[(int)Action::Count];
+	bool tapped[(int)Action::Count]; //Went down since the last tick, even if it's back up now
+	unsigned long long oldestEventTime;
+};
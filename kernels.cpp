@@ -0,0 +1,98 @@
+#include "kernels.h"
+
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ALIEN8_X86 1
+const PixelKernels* sse2KernelsImpl();
+const PixelKernels* avx2KernelsImpl();
+#endif
+
+static void fillScalar(uint32_t* pixels, int count, uint32_t color) {
+	for (int i = 0; i < count; i++) {
+		pixels[i] = color;
+	}
+}
+
+static void blitScalar(uint32_t* destination, const uint32_t* source, int count) {
+	for (int i = 0; i < count; i++) {
+		destination[i] = source[i];
+	}
+}
+
+static void blitMaskedScalar(uint32_t* destination, const uint32_t* source, int count, uint32_t colorKey) {
+	for (int i = 0; i < count; i++) {
+		if (source[i] != colorKey) {
+			destination[i] = source[i];
+		}
+	}
+}
+
+//Writes bytes rather than 32-bit values, so the pixels come out in RGBA order whatever the endianness
+static void bgrToRgbaScalar(uint32_t* destination, const unsigned char* source, int count) {
+	unsigned char* pixel = (unsigned char*)destination;
+	for (int i = 0; i < count; i++) {
+		pixel[0] = source[2];
+		pixel[1] = source[1];
+		pixel[2] = source[0];
+		pixel[3] = 255;
+		pixel += 4;
+		source += 3;
+	}
+}
+
+static const PixelKernels SCALAR_KERNELS = { "scalar", fillScalar, blitScalar, blitMaskedScalar, bgrToRgbaScalar };
+
+#ifdef ALIEN8_X86
+//AVX2 needs both the CPU flag and the OS saving the upper halves of the registers
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+const PixelKernels& scalarKernels() {
+	return SCALAR_KERNELS;
+}
+
+const PixelKernels* sse2Kernels() {
+#ifdef ALIEN8_X86
+	return sse2KernelsImpl(); //Every x86 CPU we run on has SSE2
+#else
+	return NULL;
+#endif
+}
+
+const PixelKernels* avx2Kernels() {
+#ifdef ALIEN8_X86
+	static const bool supported = cpuHasAvx2();
+	return supported ? avx2KernelsImpl() : NULL;
+#else
+	return NULL;
+#endif
+}
+
+const PixelKernels& pixelKernels() {
+	static const PixelKernels* best = avx2Kernels() ? avx2Kernels() : sse2Kernels() ? sse2Kernels() : &SCALAR_KERNELS;
+	return *best;
+}
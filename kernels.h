@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+//Loops over runs of 32-bit pixels, in a scalar version and SSE2/AVX2 versions that are picked at startup
+struct PixelKernels {
+	const char* name;
+	void (*fill)(uint32_t* pixels, int count, uint32_t color);
+	void (*blit)(uint32_t* destination, const uint32_t* source, int count);
+	//Like blit, but source pixels equal to colorKey are left out
+	void (*blitMasked)(uint32_t* destination, const uint32_t* source, int count, uint32_t colorKey);
+	//Turn 3 byte BGR pixels, the way BMP files store them, into RGBA ones with full alpha
+	void (*bgrToRgba)(uint32_t* destination, const unsigned char* source, int count);
+};
+
+//The fastest kernels this CPU supports
+const PixelKernels& pixelKernels();
+
+//Every version, for benchmarking and checking them against each other. The SIMD ones are NULL when the CPU or build lacks them
+const PixelKernels& scalarKernels();
+const PixelKernels* sse2Kernels();
+const PixelKernels* avx2Kernels();
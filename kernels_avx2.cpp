@@ -0,0 +1,72 @@
+#include "kernels.h"
+
+//Built with AVX2 code generation enabled, nothing in here may run before avx2Kernels() has checked the CPU
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+
+#include <immintrin.h>
+
+static void fillAvx2(uint32_t* pixels, int count, uint32_t color) {
+	__m256i value = _mm256_set1_epi32((int)color);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_si256((__m256i*)(pixels + i), value);
+	}
+	for (; i < count; i++) {
+		pixels[i] = color;
+	}
+}
+
+static void blitAvx2(uint32_t* destination, const uint32_t* source, int count) {
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_loadu_si256((const __m256i*)(source + i)));
+	}
+	for (; i < count; i++) {
+		destination[i] = source[i];
+	}
+}
+
+//Pick the destination where the source matches the key and the source everywhere else, eight pixels at a time
+static void blitMaskedAvx2(uint32_t* destination, const uint32_t* source, int count, uint32_t colorKey) {
+	__m256i key = _mm256_set1_epi32((int)colorKey);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i from = _mm256_loadu_si256((const __m256i*)(source + i));
+		__m256i to = _mm256_loadu_si256((const __m256i*)(destination + i));
+		__m256i keyed = _mm256_cmpeq_epi32(from, key);
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_blendv_epi8(from, to, keyed));
+	}
+	for (; i < count; i++) {
+		if (source[i] != colorKey) {
+			destination[i] = source[i];
+		}
+	}
+}
+
+//Eight pixels at a time, four from each 12 byte half put in its own 128-bit lane where one byte shuffle reorders them.
+//The second half's load reads 4 bytes past the 24 it uses, so the last few pixels are left to the scalar tail
+static void bgrToRgbaAvx2(uint32_t* destination, const unsigned char* source, int count) {
+	const __m256i order = _mm256_setr_epi8(
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+	int i = 0;
+	for (; i + 10 <= count; i += 8) {
+		const unsigned char* pixel = source + i * 3;
+		__m256i bgr = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)pixel)),
+			_mm_loadu_si128((const __m128i*)(pixel + 12)), 1);
+		_mm256_storeu_si256((__m256i*)(destination + i), _mm256_or_si256(_mm256_shuffle_epi8(bgr, order), alpha));
+	}
+	for (; i < count; i++) {
+		const unsigned char* pixel = source + i * 3;
+		destination[i] = 0xFF000000u | (uint32_t)pixel[0] << 16 | (uint32_t)pixel[1] << 8 | pixel[2];
+	}
+}
+
+static const PixelKernels AVX2_KERNELS = { "avx2", fillAvx2, blitAvx2, blitMaskedAvx2, bgrToRgbaAvx2 };
+
+const PixelKernels* avx2KernelsImpl() {
+	return &AVX2_KERNELS;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+
+#include <emmintrin.h>
+
+static void fillSse2(uint32_t* pixels, int count, uint32_t color) {
+	__m128i value = _mm_set1_epi32((int)color);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_si128((__m128i*)(pixels + i), value);
+	}
+	for (; i < count; i++) {
+		pixels[i] = color;
+	}
+}
+
+static void blitSse2(uint32_t* destination, const uint32_t* source, int count) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_loadu_si128((const __m128i*)(source + i)));
+	}
+	for (; i < count; i++) {
+		destination[i] = source[i];
+	}
+}
+
+//Pick the destination where the source matches the key and the source everywhere else, four pixels at a time
+static void blitMaskedSse2(uint32_t* destination, const uint32_t* source, int count, uint32_t colorKey) {
+	__m128i key = _mm_set1_epi32((int)colorKey);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i from = _mm_loadu_si128((const __m128i*)(source + i));
+		__m128i to = _mm_loadu_si128((const __m128i*)(destination + i));
+		__m128i keyed = _mm_cmpeq_epi32(from, key);
+		_mm_storeu_si128((__m128i*)(destination + i), _mm_or_si128(_mm_and_si128(keyed, to), _mm_andnot_si128(keyed, from)));
+	}
+	for (; i < count; i++) {
+		if (source[i] != colorKey) {
+			destination[i] = source[i];
+		}
+	}
+}
+
+//SSE2 has no byte shuffle, so shift each of four pixels down to the bottom of its own register, gather the four
+//into one and swap red and blue with shifts and masks. Every load reads 16 bytes for the 12 it uses, so the last
+//few pixels are left to the scalar tail rather than reading past the end of the source
+static void bgrToRgbaSse2(uint32_t* destination, const unsigned char* source, int count) {
+	const __m128i green = _mm_set1_epi32(0x0000FF00);
+	const __m128i low = _mm_set1_epi32(0x000000FF);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	int i = 0;
+	for (; i + 6 <= count; i += 4) {
+		__m128i bgr = _mm_loadu_si128((const __m128i*)(source + i * 3));
+		__m128i first = _mm_unpacklo_epi32(bgr, _mm_srli_si128(bgr, 3));
+		__m128i second = _mm_unpacklo_epi32(_mm_srli_si128(bgr, 6), _mm_srli_si128(bgr, 9));
+		__m128i pixels = _mm_unpacklo_epi64(first, second);
+
+		__m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), low);
+		__m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, low), 16);
+		__m128i rgba = _mm_or_si128(_mm_or_si128(red, blue), _mm_or_si128(_mm_and_si128(pixels, green), alpha));
+		_mm_storeu_si128((__m128i*)(destination + i), rgba);
+	}
+	for (; i < count; i++) {
+		const unsigned char* pixel = source + i * 3;
+		destination[i] = 0xFF000000u | (uint32_t)pixel[0] << 16 | (uint32_t)pixel[1] << 8 | pixel[2];
+	}
+}
+
+static const PixelKernels SSE2_KERNELS = { "sse2", fillSse2, blitSse2, blitMaskedSse2, bgrToRgbaSse2 };
+
+const PixelKernels* sse2KernelsImpl() {
+	return &SSE2_KERNELS;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include "latency.h"
+
+#include <algorithm>
+
+void LatencyTracker::inputChanged(unsigned long long time) {
+	waiting.push_back(time);
+}
+
+void LatencyTracker::inputConsumed() {
+	consumed.insert(consumed.end(), waiting.begin(), waiting.end());
+	waiting.clear();
+}
+
+void LatencyTracker::presented(unsigned long long time) {
+	for (unsigned long long changed : consumed) {
+		samples.push_back(time - changed);
+	}
+	consumed.clear();
+}
+
+void LatencyTracker::printStats(std::ostream& out) const {
+	if (samples.empty()) {
+		out << "input latency: no samples" << std::endl;
+		return;
+	}
+
+	std::vector<unsigned long long> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	auto percentileMs = [&](double p) { return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)] / 1e6; };
+
+	out << "input latency: " << sorted.size() << " samples, p50 " << percentileMs(0.50) << " ms, p95 " << percentileMs(0.95)
+		<< " ms, p99 " << percentileMs(0.99) << " ms, max " << sorted.back() / 1e6 << " ms" << std::endl;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+//Measures input-to-present latency: how long after a key went down or up the first frame showing its effect was
+//presented. Times are nanoseconds from Profiler::now()
+class LatencyTracker {
+public:
+	//A key changed state at this time
+	void inputChanged(unsigned long long time);
+	//A tick has used every change seen so far, so the next presented frame reflects them
+	void inputConsumed();
+	//A frame was presented, closing every consumed change
+	void presented(unsigned long long time);
+	//Consumed changes that turned out not to change the screen, like letting go of a key, never get presented
+	void dropConsumed() { consumed.clear(); }
+
+	//For changes tracked somewhere else, like across the pipeline threads
+	void addSample(unsigned long long latency) { samples.push_back(latency); }
+
+	void printStats(std::ostream& out) const;
+
+private:
+	std::vector<unsigned long long> waiting; //Seen but not ticked yet
+	std::vector<unsigned long long> consumed; //Ticked but not presented yet
+	std::vector<unsigned long long> samples;
+};
@@ -1,20 +1,58 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "framelimiter.h"
+#include "game.h"
+#include "gputimer.h"
+#include "input.h"
+#include "latency.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "replay.h"
+#include "renderer.h"
+#include "screentexture.h"
+#include "tilemap.h"
+#include "timestep.h"
+
 #include <iostream>
-#include <vector>
-#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
 
 void onFrameBufferSize(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow* window);
-void tick();
+void onWindowRefresh(GLFWwindow* window);
+void onKey(GLFWwindow* window, int key, int scancode, int action, int mods);
 int compileVertexShader(const char* source);
 int compileFragmentShader(const char* source);
 int linkShaders(const int vertexShader, const int fragmentShader);
+void uploadPalette(int shaderProgram, const Palette& palette);
+
+//Relative to the working directory, which is the project directory when started from Visual Studio
+static const char* SCENE_PATH = "misc/testscene.bmp";
+
+//Set when the window was resized or uncovered, so the last frame has to be drawn again even if nothing changed
+static bool windowDamaged = true;
+
+//Keys the game reacts to. Several keys can share an action
+struct KeyBinding {
+	int key;
+	Action action;
+};
+
+static const KeyBinding KEY_BINDINGS[] = {
+	{ GLFW_KEY_A, Action::Left },
+	{ GLFW_KEY_D, Action::Right },
+	{ GLFW_KEY_W, Action::Up },
+	{ GLFW_KEY_S, Action::Down },
+	{ GLFW_KEY_LEFT, Action::Left },
+	{ GLFW_KEY_RIGHT, Action::Right },
+	{ GLFW_KEY_UP, Action::Up },
+	{ GLFW_KEY_DOWN, Action::Down }
+};
 
-// settings
-static const unsigned int SCREEN_WIDTH = 128;
-static const unsigned int SCREEN_HEIGHT = 72;
+//Where onKey sends bound keys, it runs on the main thread from inside glfwPollEvents
+static InputQueue* keyEvents = NULL;
+static bool dumpRequested = false; //F2 was pressed
 
 const char* VERTEX_SHADER_SRC = 
 "#version 330 core\n"
@@ -35,46 +73,123 @@ const char* FRAGMENT_SHADER_SRC =
 "in vec2 outUv;\n"
 "out vec4 FragColor;\n"
 "uniform sampler2D tex;\n"
+"uniform int format;\n" //0 for RGBA, 1 for palette indices, 2 for a Spectrum bitmap + attributes
+"uniform ivec2 screenSize;\n"
+"uniform vec4 palette[16];\n"
 "void main() {\n"
-	"FragColor = texture(tex, outUv) * vec4(outCol, 1.0);\n"
+	"vec4 color = texture(tex, outUv);\n"
+	"if (format == 1) {\n"
+		"color = palette[int(color.r * 255.0 + 0.5)];\n"
+	"}\n"
+	"else if (format == 2) {\n"
+		"ivec2 pixel = min(ivec2(outUv * vec2(screenSize)), screenSize - 1);\n"
+		"int bits = int(texelFetch(tex, ivec2(pixel.x / 8, pixel.y), 0).r * 255.0 + 0.5);\n"
+		"int attributes = int(texelFetch(tex, ivec2(pixel.x / 8, screenSize.y + pixel.y / 8), 0).r * 255.0 + 0.5);\n"
+		"bool ink = ((bits >> (7 - pixel.x % 8)) & 1) != 0;\n"
+		"int index = (ink ? attributes : attributes >> 3) & 7;\n"
+		"color = palette[(attributes & 64) != 0 ? index + 8 : index];\n"
+	"}\n"
+	"FragColor = color * vec4(outCol, 1.0);\n"
 "};\n";
 
-struct Sprite {
-	unsigned char x;
-	unsigned char y;
-};
-
-std::vector<Sprite*> sprites;
-std::vector<Sprite*> spritesForScanline;
-Sprite testSprite;
-
-bool left;
-bool right;
-bool up;
-bool down;
-
-int main()
+int main(int argc, char** argv)
 {
-	testSprite.x = 24;
-	testSprite.y = 8;
-
-	sprites.push_back(&testSprite);
-
-	long size = 3 * SCREEN_WIDTH * SCREEN_HEIGHT;
-	char* buffer = new char[size];
-	std::ifstream infile("D:\\GitHub\\alien8\\Alien8\\misc\\testscene.bmp");
-	infile.seekg(0, infile.end);
-	size_t length = infile.tellg();
-	infile.seekg(53, infile.beg);
-
-	if (length > size)
-	{
-		length = size;
+	//--upload picks how frames get to the GPU, legacy reallocates the texture every frame like we used to, for comparing timings
+	//--format indexed paints one palette index per pixel and spectrum a 1bpp bitmap with attributes, both coloured by the fragment shader
+	//--threads paints the screen in that many horizontal bands at once
+	//--pipeline simulates and paints on their own threads, up to that many frames ahead of what is on screen
+	//--tick-rate sets how many times a second the game updates, however fast frames are drawn
+	//--vsync off stops waiting for the monitor, --fps caps the frame rate with or without it
+	//--no-idle keeps drawing frames while nothing on screen changes, instead of waiting for input
+	//--profile records how long each stage of a frame takes, F2 or quitting writes them to that file as a Chrome trace
+	//--latency reports how long key presses take to reach the screen, waiting for every frame to be presented to find out
+	//--late-latch waits that many ms after a frame is presented before reading input for the next, so input is fresher when
+	//the frame shows. Raise it until frames start missing vsync
+	//--record saves the input of every tick to that file, for Alien8Bench --replay
+	//--frames quits after that many frames and --verify then checks the texture against the renderer, for running under Mesa in CI
+	UploadMode uploadMode = UploadMode::Streaming;
+	PixelFormat pixelFormat = PixelFormat::Rgba;
+	int maxFrames = 0;
+	int threads = 1;
+	int pipelineDepth = 0;
+	double tickRate = TICK_RATE;
+	bool vsync = true;
+	double targetFps = 0.0;
+	bool idle = true;
+	const char* profilePath = NULL;
+	bool measureLatency = false;
+	double lateLatchMs = 0.0;
+	const char* recordPath = NULL;
+	bool verify = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--upload") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "legacy") == 0) {
+				uploadMode = UploadMode::Legacy;
+			}
+			else if (strcmp(argv[i], "subimage") == 0) {
+				uploadMode = UploadMode::SubImage;
+			}
+			else if (strcmp(argv[i], "streaming") == 0) {
+				uploadMode = UploadMode::Streaming;
+			}
+		}
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			i++;
+			if (strcmp(argv[i], "rgba") == 0) {
+				pixelFormat = PixelFormat::Rgba;
+			}
+			else if (strcmp(argv[i], "indexed") == 0) {
+				pixelFormat = PixelFormat::Indexed;
+			}
+			else if (strcmp(argv[i], "spectrum") == 0) {
+				pixelFormat = PixelFormat::Spectrum;
+			}
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+			pipelineDepth = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+			//A rate that isn't a positive number would make the tick length infinite, negative or zero
+			char* end;
+			tickRate = strtod(argv[++i], &end);
+			if (end == argv[i] || *end != '\0' || !(tickRate > 0.0) || !std::isfinite(tickRate)) {
+				std::cout << "ERROR::ARGUMENTS::TICK_RATE " << argv[i] << " is not a positive number of ticks per second" << std::endl;
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--vsync") == 0 && i + 1 < argc) {
+			vsync = strcmp(argv[++i], "off") != 0;
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			targetFps = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-idle") == 0) {
+			idle = false;
+		}
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+			profilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--latency") == 0) {
+			measureLatency = true;
+		}
+		else if (strcmp(argv[i], "--late-latch") == 0 && i + 1 < argc) {
+			lateLatchMs = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			maxFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--verify") == 0) {
+			verify = true;
+		}
 	}
 
-	infile.read(buffer, length);
-
-
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -90,6 +205,9 @@ int main()
 
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, onFrameBufferSize);
+	glfwSetWindowRefreshCallback(window, onWindowRefresh);
+	glfwSetKeyCallback(window, onKey);
+	glfwSwapInterval(vsync ? 1 : 0);
 
 	//Load all function pointers for GL stuff with glad
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -142,97 +260,261 @@ int main()
 	// uncomment this call to draw in wireframe polygons.
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-	//Generate a texture
-	unsigned int screenTex;
-	glGenTextures(1, &screenTex);
-	glBindTexture(GL_TEXTURE_2D, screenTex);
-	// set the texture wrapping/filtering options (on the currently bound texture object)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	const int imageDataLength = SCREEN_WIDTH * SCREEN_HEIGHT * 4; //4 because RGBA components
-	unsigned char* imageData = new unsigned char[imageDataLength];
-
-	/*int bufPos = 1;
-	for (int i = 0; i < imageDataLength; i += 4) {
-		imageData[i] = buffer[bufPos + 2];
-		imageData[i + 1] = buffer[bufPos + 1];
-		imageData[i + 2] = buffer[bufPos];
-		imageData[i + 3] = 255;
-
-		bufPos += 3;
-		if (bufPos % (387) == 0) {
-			bufPos += 1;
-		}
-	}*/
-
-	//Initialize imageData
-	for (int i = 0; i < imageDataLength; i += 4) {
-		imageData[i] = 0;
-		imageData[i + 1] = 0;
-		imageData[i + 2] = 0;
-		imageData[i + 3] = 255;
+	ScreenTexture* screen = new ScreenTexture(uploadMode, pixelFormat);
+
+	Game game;
+	Renderer renderer(pixelFormat, threads);
+
+	//The test scene as tiles behind the sprites, or just black without it
+	TileMap scene;
+	if (scene.load(SCENE_PATH, game.palette)) {
+		game.background = &scene;
+	}
+	else {
+		std::cout << "Could not read " << SCENE_PATH << std::endl;
 	}
 
-	while (!glfwWindowShouldClose(window))
+	//Key events for whichever thread ticks the game
+	InputQueue inputs;
+	keyEvents = &inputs;
+
+	glUseProgram(shaderProgram);
+	glUniform1i(glGetUniformLocation(shaderProgram, "format"), (int)pixelFormat);
+	glUniform2i(glGetUniformLocation(shaderProgram, "screenSize"), SCREEN_WIDTH, SCREEN_HEIGHT);
+	unsigned int paletteVersion = game.palette.version;
+	uploadPalette(shaderProgram, game.palette);
+
+	//Frame timing, printed once a second
+	double statsStart = glfwGetTime();
+	double uploadTime = 0.0;
+	long long damagedPixels = 0;
+	long long bytesUploaded = 0;
+	int statsFrames = 0;
+	long long reportedDroppedTicks = 0; //Catch-up ticks skipped up to the last stats line
+	int frames = 0;
+
+	Damage damage;
+
+	//The game ticks at a fixed rate and frames in between are drawn from a blend of the last two ticks
+	FixedTimestep timestep(tickRate);
+	Game previous = game;
+	Game interpolated = game;
+	unsigned long long lastTime = Profiler::now();
+	InputLog recording(tickRate);
+	if (game.background != NULL) {
+		recording.setScene(SCENE_PATH);
+	}
+	Recorder recorder(recording);
+
+	//Simulation and painting move to their own threads, the loop below only uploads and draws what they finished
+	Pipeline* pipeline = pipelineDepth > 0 ? new Pipeline(game, inputs, pixelFormat, pipelineDepth, threads, tickRate, recordPath != NULL ? &recording : NULL) : NULL;
+	const Frame* frame = NULL;
+
+	FrameLimiter limiter(targetFps);
+
+	//Upload and draw time on the GPU side, CPU timers only see the calls being queued
+	GpuTimer* gpuTimer = new GpuTimer();
+
+	Profiler::get().setEnabled(profilePath != NULL);
+
+	LatencyTracker latency;
+
+	while (!glfwWindowShouldClose(window) && (maxFrames == 0 || frames < maxFrames))
 	{
-		processInput(window);
-		tick();
-
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		//Re-paint the screen
-		for (int i = 0; i < imageDataLength; i += 4) {
-			int pixelIndex = i / 4;
-			int x = pixelIndex % SCREEN_WIDTH;
-			int y = pixelIndex / SCREEN_WIDTH;
-
-			imageData[i] = 0;
-			imageData[i + 1] = 0;
-			imageData[i + 2] = 0;
-			imageData[i + 3] = 255;
-
-			//See if any sprites need to be drawn this scanline
-			if (x == 0) {
-				spritesForScanline.clear();
-
-				for (auto const& value : sprites) {
-					if (value->y >= y && value->y <= y + 8) {
-						spritesForScanline.push_back(value);
-					}
+		PROFILE_SCOPE("frame");
+
+		if (dumpRequested && profilePath != NULL) {
+			Profiler::get().writeChromeTrace(profilePath);
+			Profiler::get().printStats(std::cout);
+		}
+		dumpRequested = false;
+
+		double uploadStart;
+		if (pipeline) {
+			{
+				PROFILE_SCOPE("wait");
+				frame = pipeline->nextFrame();
+			}
+
+			PROFILE_SCOPE("upload");
+			uploadStart = glfwGetTime();
+			gpuTimer->beginFrame();
+			gpuTimer->start(GpuTimer::STAGE_UPLOAD);
+			screen->present(frame->imageData.data());
+			gpuTimer->stop(GpuTimer::STAGE_UPLOAD);
+		}
+		else {
+			{
+				PROFILE_SCOPE("tick");
+				int ticks = runTicks(timestep, inputs, Profiler::now(), lastTime, game, previous, recordPath != NULL ? &recorder : NULL,
+					[&](unsigned long long time) {
+						if (measureLatency) {
+							latency.inputChanged(time);
+						}
+					});
+				if (measureLatency && ticks > 0) {
+					latency.inputConsumed();
 				}
+				interpolate(previous, game, timestep.getAlpha(), interpolated);
 			}
 
-			//Draw sprites from current scanline
-			for (auto const& value : spritesForScanline) {
-				if (value->x >= x && value->x <= x + 8) {
-					imageData[i + 1] = 255; //Make it green, for now
+			//Nothing moved, nothing is held down and the window is intact, so skip the frame and sleep until an event or the next tick
+			renderer.findDamage(interpolated, damage);
+			if (idle && damage.isEmpty() && !inputs.isAnyHeld() && !windowDamaged && interpolated.palette.version == paletteVersion) {
+				if (measureLatency) {
+					latency.dropConsumed();
 				}
+				glfwWaitEventsTimeout(timestep.getTimeToNextTick());
+				frames++; //Still counts towards --frames, so a run without input finishes
+				continue;
 			}
 
-			//std::cout << "x" << x << "\ny" << y << std::endl;
+			//Re-paint only what changed, the screen texture tells us how much that is for the buffer we got
+			{
+				PROFILE_SCOPE("paint");
+				unsigned char* imageData = screen->beginFrame(damage);
+				renderer.render(interpolated, imageData, screen->getRepaint());
+			}
+
+			PROFILE_SCOPE("upload");
+			uploadStart = glfwGetTime();
+			gpuTimer->beginFrame();
+			gpuTimer->start(GpuTimer::STAGE_UPLOAD);
+			screen->endFrame();
+			gpuTimer->stop(GpuTimer::STAGE_UPLOAD);
+		}
+		uploadTime += glfwGetTime() - uploadStart;
+		const Game& shown = pipeline ? frame->state : interpolated;
+		damagedPixels += screen->getDamagedPixels();
+		bytesUploaded += screen->getBytesUploaded();
+
+		{
+			PROFILE_SCOPE("draw");
+			gpuTimer->start(GpuTimer::STAGE_DRAW);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			glUseProgram(shaderProgram);
+			if (shown.palette.version != paletteVersion) {
+				uploadPalette(shaderProgram, shown.palette);
+				paletteVersion = shown.palette.version;
+			}
+			screen->bind();
+			glBindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			gpuTimer->stop(GpuTimer::STAGE_DRAW);
+			gpuTimer->endFrame();
+			windowDamaged = false;
+		}
+
+		{
+			PROFILE_SCOPE("limit");
+			limiter.wait();
+		}
+		{
+			PROFILE_SCOPE("swap");
+			glfwSwapBuffers(window);
 		}
 
-		glUseProgram(shaderProgram);
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		//Swapping only queues the frame, finishing is the closest we get to knowing when it reached the screen
+		if (measureLatency || lateLatchMs > 0.0) {
+			glFinish();
+		}
+		//Only kept with --latency, the samples would pile up for the whole run otherwise
+		if (measureLatency && pipeline) {
+			if (frame->inputTime != 0) {
+				latency.addSample(Profiler::now() - frame->inputTime);
+			}
+		}
+		else if (measureLatency) {
+			latency.presented(Profiler::now());
+		}
+
+		if (lateLatchMs > 0.0) {
+			PROFILE_SCOPE("late latch");
+			FrameLimiter::sleepFor(lateLatchMs / 1000.0);
+		}
+		{
+			PROFILE_SCOPE("input");
+			glfwPollEvents();
+		}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		frames++;
+		statsFrames++;
+		double now = glfwGetTime();
+		if (now - statsStart >= 1.0) {
+			std::cout << statsFrames / (now - statsStart) << " fps, "
+				<< (now - statsStart) * 1000.0 / statsFrames << " ms/frame, upload "
+				<< uploadTime * 1000.0 / statsFrames << " ms/frame (" << uploadModeName(screen->getMode()) << "), "
+				<< damagedPixels / statsFrames << " damaged px/frame, " << bytesUploaded / statsFrames << " bytes uploaded/frame, gpu upload "
+				<< gpuTimer->getAverageMs(GpuTimer::STAGE_UPLOAD) << " ms, gpu draw " << gpuTimer->getAverageMs(GpuTimer::STAGE_DRAW) << " ms ("
+				<< gpuTimer->getSamples() << " samples, " << gpuTimer->getDropped() << " not ready), ";
+			//Ticks the timestep skipped rather than run late after a stall
+			long long droppedTicks = pipeline ? pipeline->getDroppedTicks() : timestep.getDroppedTicks();
+			std::cout << droppedTicks - reportedDroppedTicks << " ticks dropped" << std::endl;
+			reportedDroppedTicks = droppedTicks;
+			statsStart = now;
+			uploadTime = 0.0;
+			damagedPixels = 0;
+			bytesUploaded = 0;
+			statsFrames = 0;
+			gpuTimer->resetStats();
+		}
+	}
+
+	//Read the texture back and compare it with a fresh render of the same state
+	int result = 0;
+	if (verify) {
+		unsigned char* expected = new unsigned char[renderer.getImageDataLength()];
+		unsigned char* actual = new unsigned char[renderer.getImageDataLength()];
+
+		renderer.render(frame ? frame->state : interpolated, expected);
+		screen->bind();
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(GL_TEXTURE_2D, 0, pixelFormat == PixelFormat::Rgba ? GL_RGBA : GL_RED, GL_UNSIGNED_BYTE, actual);
+
+		if (memcmp(expected, actual, renderer.getImageDataLength()) != 0) {
+			std::cout << "ERROR::VERIFY::TEXTURE_MISMATCH (" << uploadModeName(screen->getMode()) << ")" << std::endl;
+			result = 1;
+		}
+		else {
+			std::cout << "Texture matches the renderer after " << frames << " frames (" << uploadModeName(screen->getMode()) << ")" << std::endl;
+		}
+
+		delete[] expected;
+		delete[] actual;
+	}
+
+	delete pipeline;
+	keyEvents = NULL;
+
+	if (recordPath != NULL) {
+		if (recording.save(recordPath)) {
+			std::cout << "Recorded " << recording.getTickCount() << " ticks to " << recordPath << std::endl;
+		}
+		else {
+			std::cout << "ERROR::RECORD::SAVE_FAILED " << recordPath << std::endl;
+		}
 	}
 
+	if (measureLatency) {
+		latency.printStats(std::cout);
+	}
+
+	if (profilePath != NULL) {
+		if (Profiler::get().writeChromeTrace(profilePath)) {
+			std::cout << "Wrote trace to " << profilePath << std::endl;
+		}
+		Profiler::get().printStats(std::cout);
+	}
+	delete gpuTimer;
+	delete screen;
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
 
 	glfwTerminate();
-	delete[] imageData;
 
-	return 0;
+	return result;
 }
 
 int compileVertexShader(const char* source) {
@@ -286,64 +568,62 @@ int linkShaders(const int vertexShader, const int fragmentShader) {
 	return shaderProgram;
 }
 
-void processInput(GLFWwindow* window)
-{
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, true);
-
-	int leftKey = glfwGetKey(window, GLFW_KEY_A);
-	int rightKey = glfwGetKey(window, GLFW_KEY_D);
-	int upKey = glfwGetKey(window, GLFW_KEY_W);
-	int downKey = glfwGetKey(window, GLFW_KEY_S);
-
-	if (leftKey == GLFW_PRESS) {
-		left = true;
-	}
-	if (leftKey == GLFW_RELEASE) {
-		left = false;
+//Hand the palette to the fragment shader, which is all a palette effect costs in indexed mode
+void uploadPalette(int shaderProgram, const Palette& palette) {
+	float colors[PALETTE_SIZE * 4];
+	for (int i = 0; i < PALETTE_SIZE; i++) {
+		for (int j = 0; j < 4; j++) {
+			colors[i * 4 + j] = palette.colors[i][j] / 255.0f;
+		}
 	}
 
-	if (rightKey == GLFW_PRESS) {
-		right = true;
-	}
-	if (rightKey == GLFW_RELEASE) {
-		right = false;
-	}
+	glUniform4fv(glGetUniformLocation(shaderProgram, "palette"), PALETTE_SIZE, colors);
+}
 
-	if (upKey == GLFW_PRESS) {
-		up = true;
-	}
-	if (upKey == GLFW_RELEASE) {
-		up = false;
+void onKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (action == GLFW_REPEAT || key < 0 || key > GLFW_KEY_LAST) {
+		return;
 	}
 
-	if (downKey == GLFW_PRESS) {
-		down = true;
+	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
 	}
-	if (downKey == GLFW_RELEASE) {
-		down = false;
+	if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+		dumpRequested = true;
 	}
-}
 
-void tick() {
-	if (up) {
-		testSprite.y -= 1;
-	}
+	static bool keyDown[GLFW_KEY_LAST + 1];
+	keyDown[key] = action == GLFW_PRESS;
 
-	if (down) {
-		testSprite.y += 1;
-	}
+	for (auto const& binding : KEY_BINDINGS) {
+		if (binding.key != key || keyEvents == NULL) {
+			continue;
+		}
 
-	if (left) {
-		testSprite.x -= 1;
-	}
+		//Another key bound to the same action can still be holding it down
+		bool pressed = false;
+		for (auto const& other : KEY_BINDINGS) {
+			if (other.action == binding.action && keyDown[other.key]) {
+				pressed = true;
+			}
+		}
 
-	if (right) {
-		testSprite.x += 1;
+		InputEvent event;
+		event.time = Profiler::now();
+		event.action = binding.action;
+		event.pressed = pressed;
+		keyEvents->push(event);
 	}
 }
 
 void onFrameBufferSize(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
+	windowDamaged = true;
+}
+
+void onWindowRefresh(GLFWwindow* window)
+{
+	windowDamaged = true;
 }
\ No newline at end of file
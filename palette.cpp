@@ -0,0 +1,21 @@
+#include "palette.h"
+
+Palette::Palette() : version(0) {
+	for (int i = 0; i < PALETTE_SIZE; i++) {
+		unsigned char intensity = i >= PALETTE_BRIGHT ? 255 : 215;
+		int color = i % PALETTE_BRIGHT;
+
+		//The colour number's bits are blue, red and green
+		set(i, color & 2 ? intensity : 0, color & 4 ? intensity : 0, color & 1 ? intensity : 0);
+	}
+
+	version = 0;
+}
+
+void Palette::set(int index, unsigned char r, unsigned char g, unsigned char b) {
+	colors[index][0] = r;
+	colors[index][1] = g;
+	colors[index][2] = b;
+	colors[index][3] = 255;
+	version++;
+}
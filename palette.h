@@ -0,0 +1,27 @@
+#pragma once
+
+static const int PALETTE_SIZE = 16;
+
+//Laid out like the ZX Spectrum's colours, the eight normal ones and then their bright versions
+enum PaletteColor : unsigned char {
+	PALETTE_BLACK = 0,
+	PALETTE_BLUE,
+	PALETTE_RED,
+	PALETTE_MAGENTA,
+	PALETTE_GREEN,
+	PALETTE_CYAN,
+	PALETTE_YELLOW,
+	PALETTE_WHITE,
+	PALETTE_BRIGHT //Add to any of the above
+};
+
+//The colours every palette index maps to. Flashes, fades and colour cycling are done by changing these,
+//which costs nothing in indexed mode since no pixel has to be repainted
+struct Palette {
+	unsigned char colors[PALETTE_SIZE][4]; //RGBA
+	unsigned int version; //Bumped on every change, so anything caching the colours knows to refresh
+
+	Palette();
+
+	void set(int index, unsigned char r, unsigned char g, unsigned char b);
+};
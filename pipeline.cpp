@@ -0,0 +1,124 @@
+#include "pipeline.h"
+#include "framelimiter.h"
+#include "profiler.h"
+
+#include <memory>
+#include <utility>
+
+Pipeline::Pipeline(const Game& game, InputQueue& inputs, PixelFormat format, int depth, int renderThreads, double tickRate,
+	InputLog* recording)
+	: game(game), inputs(inputs), recording(recording), tickRate(tickRate), renderer(format, renderThreads), snapshots(depth), freeSnapshots(depth + 2), rendered(depth), released(depth + 1), presenting(NULL), running(true), droppedTicks(0) {
+	//Enough frames for every queue slot plus the one on screen
+	frames.resize(depth + 1);
+	for (auto& frame : frames) {
+		frame.imageData.resize(renderer.getImageDataLength());
+		Frame* free = &frame;
+		released.push(std::move(free));
+	}
+
+	//Enough snapshots to fill the queue while the simulation fills one more and the renderer paints another
+	snapshotSlots.resize(depth + 2);
+	for (auto& slot : snapshotSlots) {
+		Snapshot* free = &slot;
+		freeSnapshots.push(std::move(free));
+	}
+
+	simulationThread = std::thread(&Pipeline::simulate, this);
+	renderThread = std::thread(&Pipeline::render, this);
+}
+
+Pipeline::~Pipeline() {
+	running = false;
+	snapshots.close();
+	freeSnapshots.close();
+	rendered.close();
+	released.close();
+	simulationThread.join();
+	renderThread.join();
+}
+
+const Frame* Pipeline::nextFrame() {
+	Frame* frame;
+	if (!rendered.popWait(frame)) {
+		return NULL;
+	}
+
+	//The previous frame has been replaced on screen, the renderer can have it back
+	if (presenting != NULL) {
+		released.push(std::move(presenting));
+	}
+	presenting = frame;
+
+	return frame;
+}
+
+void Pipeline::simulate() {
+	FixedTimestep timestep(tickRate);
+	Game previous = game;
+	unsigned long long last = Profiler::now();
+	std::unique_ptr<Recorder> recorder(recording != NULL ? new Recorder(*recording) : NULL);
+
+	Snapshot* snapshot = NULL;
+	double publishedAlpha = -1.0;
+
+	//One pass per snapshot the renderer takes, running however many ticks fell due since the last one
+	while (running) {
+		if (snapshot == NULL) {
+			if (!freeSnapshots.popWait(snapshot)) {
+				return;
+			}
+			snapshot->inputTime = 0;
+		}
+
+		int ticks;
+		{
+			PROFILE_SCOPE("tick");
+			ticks = runTicks(timestep, inputs, Profiler::now(), last, game, previous, recorder.get(), [&](unsigned long long time) {
+				if (snapshot->inputTime == 0) {
+					snapshot->inputTime = time;
+				}
+			});
+		}
+		droppedTicks = timestep.getDroppedTicks();
+
+		//The same state as last time would only be painted again, so keep the snapshot and let the clock move on
+		if (ticks == 0 && timestep.getAlpha() == publishedAlpha) {
+			FrameLimiter::sleepFor(0.001);
+			continue;
+		}
+		interpolate(previous, game, timestep.getAlpha(), snapshot->state);
+		publishedAlpha = timestep.getAlpha();
+
+		//Blocks while the renderer is depth snapshots behind, which is what keeps the latency bounded
+		if (!snapshots.pushWait(std::move(snapshot))) {
+			return;
+		}
+		snapshot = NULL;
+	}
+}
+
+void Pipeline::render() {
+	unsigned long long sequence = 0;
+
+	while (running) {
+		Snapshot* snapshot;
+		Frame* frame;
+		if (!snapshots.popWait(snapshot) || !released.popWait(frame)) {
+			return;
+		}
+
+		{
+			PROFILE_SCOPE("paint");
+			renderer.render(snapshot->state, frame->imageData.data());
+		}
+		//Swapped rather than copied, so the snapshot goes back holding the old frame's sprite arrays to be refilled
+		std::swap(frame->state, snapshot->state);
+		frame->inputTime = snapshot->inputTime;
+		frame->sequence = ++sequence;
+		freeSnapshots.push(std::move(snapshot));
+
+		if (!rendered.pushWait(std::move(frame))) {
+			return;
+		}
+	}
+}
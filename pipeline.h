@@ -0,0 +1,65 @@
+#pragma once
+
+#include "game.h"
+#include "input.h"
+#include "replay.h"
+#include "renderer.h"
+#include "spscqueue.h"
+#include "timestep.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//A rendered frame together with the (interpolated) state it was rendered from
+struct Frame {
+	std::vector<unsigned char> imageData;
+	Game state;
+	unsigned long long sequence; //Counts the frames the renderer finished, 1 for the first
+	unsigned long long inputTime; //Profiler::now() when the earliest input change this frame is the first to show was made, 0 if none
+};
+
+//Runs the simulation and the software renderer on their own threads, so while the caller presents one frame the
+//next is being painted and the one after that simulated. Stages only hand each other copies through lock-free queues
+//and sleep while there is nothing to take or no room to give, and depth bounds how many frames can be in flight
+//between simulation and presentation. Snapshots and frames are handed round and reused, so once running nothing is
+//allocated
+class Pipeline {
+public:
+	//The simulation thread becomes the consumer of inputs, and adds every tick's input to recording when there is one
+	Pipeline(const Game& game, InputQueue& inputs, PixelFormat format, int depth, int renderThreads, double tickRate = TICK_RATE,
+		InputLog* recording = NULL);
+	~Pipeline();
+
+	//Wait for the next rendered frame. It stays valid until the next call
+	const Frame* nextFrame();
+	//Catch-up ticks the simulation thread has skipped so far, see FixedTimestep
+	long long getDroppedTicks() const { return droppedTicks; }
+
+private:
+	struct Snapshot {
+		Game state;
+		unsigned long long inputTime;
+	};
+
+	void simulate();
+	void render();
+
+	Game game; //Only touched by the simulation thread once it is running
+	InputQueue& inputs;
+	InputLog* recording;
+	double tickRate;
+	Renderer renderer;
+	std::vector<Frame> frames;
+	std::vector<Snapshot> snapshotSlots;
+	SpscQueue<Snapshot*> snapshots; //Simulation to renderer
+	SpscQueue<Snapshot*> freeSnapshots; //Renderer back to simulation once painted
+	SpscQueue<Frame*> rendered; //Renderer to presenter
+	SpscQueue<Frame*> released; //Presenter back to renderer, once a frame is no longer on screen
+	Frame* presenting;
+
+	std::atomic<bool> running;
+	std::atomic<long long> droppedTicks;
+	std::thread simulationThread;
+	std::thread renderThread;
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+enum class PixelFormat {
+	Rgba,    //4 bytes per pixel, colours looked up in the palette while painting
+	Indexed, //1 byte per pixel holding a palette index, looked up by the fragment shader
+	Spectrum //1 bit per pixel plus an ink/paper attribute byte per 8x8 cell, decoded by the fragment shader
+};
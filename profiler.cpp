@@ -0,0 +1,122 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+	//Small stable numbers for the trace's thread lanes
+	std::atomic<unsigned int> nextThreadId(1);
+	thread_local unsigned int threadId = 0;
+
+	unsigned int currentThreadId() {
+		if (threadId == 0) {
+			threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+		}
+		return threadId;
+	}
+
+	unsigned long long percentile(const std::vector<unsigned long long>& sorted, double p) {
+		return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+	}
+}
+
+Profiler& Profiler::get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : enabled(false), nextEvent(0) {
+	events = new Event[CAPACITY];
+	for (unsigned int i = 0; i < CAPACITY; i++) {
+		events[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+Profiler::~Profiler() {
+	delete[] events;
+}
+
+unsigned long long Profiler::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char* name, unsigned long long start, unsigned long long end) {
+	record(name, start, end, currentThreadId());
+}
+
+void Profiler::record(const char* name, unsigned long long start, unsigned long long end, unsigned int lane) {
+	unsigned long long index = nextEvent.fetch_add(1, std::memory_order_relaxed);
+	Event& event = events[index % CAPACITY];
+
+	//Zero while the fields are being replaced, so a reader never pairs an old sequence with new fields
+	event.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event.name.store(name, std::memory_order_relaxed);
+	event.start.store(start, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+	event.thread.store(lane, std::memory_order_relaxed);
+	event.sequence.store(index + 1, std::memory_order_release);
+}
+
+template <typename Visitor>
+void Profiler::forEachEvent(Visitor visit) const {
+	unsigned long long last = nextEvent.load(std::memory_order_acquire);
+	unsigned long long first = last > CAPACITY ? last - CAPACITY : 0;
+
+	for (unsigned long long index = first; index < last; index++) {
+		const Event& event = events[index % CAPACITY];
+		if (event.sequence.load(std::memory_order_acquire) != index + 1) {
+			continue;
+		}
+
+		const char* name = event.name.load(std::memory_order_relaxed);
+		unsigned long long start = event.start.load(std::memory_order_relaxed);
+		unsigned long long end = event.end.load(std::memory_order_relaxed);
+		unsigned int thread = event.thread.load(std::memory_order_relaxed);
+
+		//Overwritten while we were reading it
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (event.sequence.load(std::memory_order_relaxed) != index + 1) {
+			continue;
+		}
+
+		visit(name, start, end, thread);
+	}
+}
+
+bool Profiler::writeChromeTrace(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	forEachEvent([&](const char* name, unsigned long long start, unsigned long long end, unsigned int thread) {
+		//Timestamps are in microseconds, keep the nanoseconds as decimals
+		fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+			first ? "" : ",\n", name, thread, start / 1000, start % 1000, (end - start) / 1000, (end - start) % 1000);
+		first = false;
+	});
+	fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+	return fclose(file) == 0;
+}
+
+void Profiler::printStats(std::ostream& out) const {
+	std::map<std::string, std::vector<unsigned long long>> durations;
+	forEachEvent([&](const char* name, unsigned long long start, unsigned long long end, unsigned int) {
+		durations[name].push_back(end - start);
+	});
+
+	for (auto& stage : durations) {
+		std::vector<unsigned long long>& sorted = stage.second;
+		std::sort(sorted.begin(), sorted.end());
+		out << stage.first << ": " << sorted.size() << " samples, p50 " << percentile(sorted, 0.50) << " ns, p95 "
+			<< percentile(sorted, 0.95) << " ns, p99 " << percentile(sorted, 0.99) << " ns, max " << sorted.back() << " ns" << std::endl;
+	}
+}
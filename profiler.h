@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <ostream>
+
+//Records how long named stages of a frame take, from any thread, into a fixed ring of the latest events.
+//Nothing is allocated or locked while recording and a disabled profiler costs one relaxed load per scope.
+//Build with ALIEN8_NO_PROFILER to compile the scopes out entirely
+class Profiler {
+public:
+	static const unsigned int CAPACITY = 1 << 16; //Events kept, older ones get overwritten
+	static const unsigned int GPU_LANE = 0; //Trace lane for work timed on the GPU, threads are numbered from 1
+
+	static Profiler& get();
+
+	void setEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	//Nanoseconds on a steady clock
+	static unsigned long long now();
+
+	//Name must outlive the profiler, a string literal. Lane defaults to the calling thread
+	void record(const char* name, unsigned long long start, unsigned long long end);
+	void record(const char* name, unsigned long long start, unsigned long long end, unsigned int lane);
+
+	//Chrome trace event JSON, for chrome://tracing or ui.perfetto.dev
+	bool writeChromeTrace(const char* path) const;
+
+	//p50/p95/p99/max for every stage name seen in the ring
+	void printStats(std::ostream& out) const;
+
+private:
+	struct Event {
+		std::atomic<unsigned long long> sequence; //Index + 1 once written, lets readers skip half written events
+		std::atomic<const char*> name;
+		std::atomic<unsigned long long> start;
+		std::atomic<unsigned long long> end;
+		std::atomic<unsigned int> thread;
+	};
+
+	Profiler();
+	~Profiler();
+
+	//Copies out the events that are fully written, oldest first
+	template <typename Visitor>
+	void forEachEvent(Visitor visit) const;
+
+	std::atomic<bool> enabled;
+	std::atomic<unsigned long long> nextEvent;
+	Event* events;
+};
+
+//Times the enclosing block as one stage
+class ProfileScope {
+public:
+	ProfileScope(const char* name) : name(name), start(Profiler::get().isEnabled() ? Profiler::now() : 0) {
+	}
+
+	~ProfileScope() {
+		if (start != 0) {
+			Profiler::get().record(name, start, Profiler::now());
+		}
+	}
+
+private:
+	const char* name;
+	unsigned long long start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ALIEN8_NO_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
@@ -0,0 +1,373 @@
+#include "renderer.h"
+#include "kernels.h"
+#include "profiler.h"
+
+#include <cstring>
+
+//Below this many damaged pixels it costs more to wake the workers than to paint them ourselves
+static const int PARALLEL_THRESHOLD = 2048;
+
+static const unsigned char SPRITE_COLOR = PALETTE_BRIGHT + PALETTE_GREEN; //Make it green, for now
+//Spectrum attribute bits are flash, bright, three of paper and three of ink. Sprites are ink, the background is paper
+static const unsigned char SPRITE_ATTRIBUTE = 0x40 | (PALETTE_BLACK << 3) | PALETTE_GREEN;
+
+ImageLayout imageLayout(PixelFormat format) {
+	switch (format) {
+	case PixelFormat::Indexed: return { (int)SCREEN_WIDTH, (int)SCREEN_HEIGHT, 1 };
+	case PixelFormat::Spectrum: return { (int)SCREEN_WIDTH / 8, (int)(SCREEN_HEIGHT + SCREEN_HEIGHT / 8), 1 };
+	default: return { (int)SCREEN_WIDTH, (int)SCREEN_HEIGHT, 4 };
+	}
+}
+
+//Set or clear the bits for pixels left up to and including right on one bitmap row, a whole byte at a time where possible
+static void fillBits(unsigned char* row, int left, int right, bool set) {
+	int first = left / 8;
+	int last = right / 8;
+	unsigned char firstMask = 0xFF >> (left % 8);
+	unsigned char lastMask = 0xFF << (7 - right % 8);
+
+	if (first == last) {
+		firstMask &= lastMask;
+	}
+
+	row[first] = set ? row[first] | firstMask : row[first] & ~firstMask;
+	if (first == last) {
+		return;
+	}
+
+	for (int i = first + 1; i < last; i++) {
+		row[i] = set ? 0xFF : 0x00;
+	}
+
+	row[last] = set ? row[last] | lastMask : row[last] & ~lastMask;
+}
+
+//The area a sprite covers, from x - width + 1 and y - height + 1 up to and including x and y. Hidden sprites cover nothing
+static Rect spriteBounds(const SpriteStore& sprites, size_t i) {
+	if ((sprites.flags[i] & SPRITE_HIDDEN) != 0) {
+		return { 0, 0, 0, 0 };
+	}
+	return { sprites.x[i] - sprites.width[i] + 1, sprites.y[i] - sprites.height[i] + 1, sprites.width[i], sprites.height[i] };
+}
+
+static bool sameRect(const Rect& a, const Rect& b) {
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+Renderer::Renderer(PixelFormat format, int threads) : format(format), window(format) {
+	//Bands are whole 8 pixel cells high, so no two of them share a row of Spectrum attributes
+	bandCount = threads;
+	if (bandCount > (int)SCREEN_HEIGHT / 8) {
+		bandCount = SCREEN_HEIGHT / 8;
+	}
+	if (bandCount > 1) {
+		pool.reset(new WorkerPool(bandCount));
+	}
+	else {
+		bandCount = 1;
+	}
+
+	fullScreen.addScreen();
+}
+
+int Renderer::getImageDataLength() const {
+	ImageLayout layout = imageLayout(format);
+	return layout.width * layout.height * layout.texelSize;
+}
+
+void Renderer::render(const Game& game, unsigned char* imageData) {
+	render(game, imageData, fullScreen);
+}
+
+void Renderer::render(const Game& game, unsigned char* imageData, const Damage& damage) {
+	binSprites(game);
+	prepareBackground(game);
+
+	if (!pool || damage.getPixelCount() < PARALLEL_THRESHOLD) {
+		for (auto const& rect : damage.getRects()) {
+			paintRect(rect, game, imageData);
+		}
+		return;
+	}
+
+	//Two pointers of captures are few enough for std::function to keep the job inline instead of allocating it
+	struct BandJob {
+		const Damage* damage;
+		const Game* game;
+		unsigned char* imageData;
+	} job = { &damage, &game, imageData };
+
+	//Every band only reads its own rows of sprite buckets and only writes its own rows of pixels
+	pool->run(bandCount, [this, &job](int band) {
+		PROFILE_SCOPE("band");
+		paintBand(band, *job.damage, *job.game, job.imageData);
+	});
+}
+
+void Renderer::findDamage(const Game& game, Damage& damage) {
+	damage.clear();
+
+	//Scrolling moves everything on screen
+	bool scrolled = game.background != NULL && (game.scrollX != previousScrollX || game.scrollY != previousScrollY);
+	if (invalidated || previousBounds.size() != game.sprites.size() || game.background != previousBackground || scrolled) {
+		damage.addScreen();
+		invalidated = false;
+		previousBackground = game.background;
+		previousScrollX = game.scrollX;
+		previousScrollY = game.scrollY;
+	}
+
+	//RGBA pixels have the palette baked in, indexed ones get their colours on the GPU
+	if (format == PixelFormat::Rgba && game.palette.version != paletteVersion) {
+		damage.addScreen();
+		paletteVersion = game.palette.version;
+	}
+
+	previousBounds.resize(game.sprites.size());
+
+	for (size_t i = 0; i < game.sprites.size(); i++) {
+		Rect bounds = spriteBounds(game.sprites, i);
+
+		if (!sameRect(bounds, previousBounds[i])) {
+			damage.add(previousBounds[i]);
+			damage.add(bounds);
+			previousBounds[i] = bounds;
+		}
+	}
+}
+
+void Renderer::invalidate() {
+	invalidated = true;
+	window.invalidate();
+}
+
+//Decode the tiles that scrolled into view. The bands only read the window, so this happens before they start
+void Renderer::prepareBackground(const Game& game) {
+	if (game.background != NULL) {
+		window.update(*game.background, game.scrollX, game.scrollY, game.palette);
+	}
+}
+
+void Renderer::paintBand(int band, const Damage& damage, const Game& game, unsigned char* imageData) {
+	const int cellRows = SCREEN_HEIGHT / 8;
+	int top = band * cellRows / bandCount * 8;
+	int bottom = (band + 1) * cellRows / bandCount * 8;
+
+	for (auto const& rect : damage.getRects()) {
+		Rect clipped = rect;
+		if (clipped.y < top) {
+			clipped.height -= top - clipped.y;
+			clipped.y = top;
+		}
+		if (clipped.y + clipped.height > bottom) {
+			clipped.height = bottom - clipped.y;
+		}
+
+		if (clipped.height > 0) {
+			paintRect(clipped, game, imageData);
+		}
+	}
+}
+
+void Renderer::paintRect(const Rect& rect, const Game& game, unsigned char* imageData) {
+	if (format == PixelFormat::Spectrum) {
+		paintRectSpectrum(rect, game, imageData);
+		return;
+	}
+
+	const Palette& palette = game.palette;
+	const int pixelSize = imageLayout(format).texelSize;
+	const int pitch = SCREEN_WIDTH * pixelSize;
+	unsigned char* row = imageData + rect.y * pitch;
+
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		if (game.background != NULL) {
+			window.copyRow(game.scrollX + rect.x, game.scrollY + y, rect.width, row + rect.x * pixelSize);
+		}
+		else {
+			fillSpan(row + rect.x * pixelSize, rect.width, PALETTE_BLACK, palette);
+		}
+
+		//Every sprite on this row is one contiguous run
+		for (int i = rowStarts[y]; i < rowStarts[y + 1]; i++) {
+			int left = spans[i].left;
+			int right = spans[i].right;
+
+			if (left < rect.x) {
+				left = rect.x;
+			}
+			if (right > rect.x + rect.width - 1) {
+				right = rect.x + rect.width - 1;
+			}
+
+			if (left <= right) {
+				fillSpan(row + left * pixelSize, right - left + 1, SPRITE_COLOR, palette);
+			}
+		}
+
+		row += pitch;
+	}
+}
+
+void Renderer::fillSpan(unsigned char* pixel, int count, unsigned char color, const Palette& palette) {
+	if (format == PixelFormat::Indexed) {
+		memset(pixel, color, count);
+		return;
+	}
+
+	//The palette already stores the bytes in RGBA order, so copying them keeps them in that order whatever the endianness
+	uint32_t rgba;
+	memcpy(&rgba, palette.colors[color], 4);
+	pixelKernels().fill((uint32_t*)pixel, count, rgba);
+}
+
+//Same as paintRect(), but sprites become ink bits and the colours live in the attributes
+void Renderer::paintRectSpectrum(const Rect& rect, const Game& game, unsigned char* imageData) {
+	const int pitch = SCREEN_WIDTH / 8;
+	const TileMap* background = game.background;
+	unsigned char* row = imageData + rect.y * pitch;
+
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		fillBits(row, rect.x, rect.x + rect.width - 1, false);
+
+		//Background bits come a byte at a time, each one masked in where the rectangle covers it
+		if (background != NULL) {
+			int first = rect.x / 8;
+			int last = (rect.x + rect.width - 1) / 8;
+			unsigned char tileBits[SCREEN_WIDTH / 8];
+			window.copyBits(game.scrollX + first * 8, game.scrollY + y, last - first + 1, tileBits);
+
+			for (int column = first; column <= last; column++) {
+				unsigned char mask = 0xFF;
+				if (column == first) {
+					mask &= 0xFF >> (rect.x % 8);
+				}
+				if (column == last) {
+					mask &= 0xFF << (7 - (rect.x + rect.width - 1) % 8);
+				}
+				row[column] |= tileBits[column - first] & mask;
+			}
+		}
+
+		for (int i = rowStarts[y]; i < rowStarts[y + 1]; i++) {
+			int left = spans[i].left;
+			int right = spans[i].right;
+
+			if (left < rect.x) {
+				left = rect.x;
+			}
+			if (right > rect.x + rect.width - 1) {
+				right = rect.x + rect.width - 1;
+			}
+
+			if (left <= right) {
+				fillBits(row, left, right, true);
+			}
+		}
+
+		row += pitch;
+	}
+
+	//Every cell the rectangle touches gets its attribute rewritten. Over a background, a cell with a sprite in it keeps
+	//the tile's paper but everything ink in it turns the sprite's colour, which is the Spectrum's colour clash
+	unsigned char* attributes = imageData + SPECTRUM_BITMAP_LENGTH;
+	int firstCellX = rect.x / 8;
+	int lastCellX = (rect.x + rect.width - 1) / 8;
+	for (int cellY = rect.y / 8; cellY <= (rect.y + rect.height - 1) / 8; cellY++) {
+		//Scrolled part way into a tile, a cell takes the colours of the tile under its middle
+		unsigned char tileAttributes[SCREEN_WIDTH / 8];
+		if (background != NULL) {
+			window.copyAttributes(game.scrollX + firstCellX * 8 + 4, game.scrollY + cellY * 8 + 4, lastCellX - firstCellX + 1, tileAttributes);
+		}
+
+		for (int cellX = firstCellX; cellX <= lastCellX; cellX++) {
+			unsigned char attribute = SPRITE_ATTRIBUTE;
+			if (background != NULL) {
+				attribute = tileAttributes[cellX - firstCellX];
+				if (hasSprite(cellX, cellY)) {
+					attribute = (attribute & 0x38) | (SPRITE_ATTRIBUTE & ~0x38);
+				}
+			}
+			attributes[cellY * pitch + cellX] = attribute;
+		}
+	}
+}
+
+//Whether any sprite covers a pixel of an 8x8 cell
+bool Renderer::hasSprite(int cellX, int cellY) const {
+	int left = cellX * 8;
+	int right = left + 7;
+
+	for (int y = cellY * 8; y < cellY * 8 + 8; y++) {
+		for (int i = rowStarts[y]; i < rowStarts[y + 1]; i++) {
+			if (spans[i].left <= right && spans[i].right >= left) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//Put the run of every sprite in the bucket of each row it covers, so the repaint only looks at runs on its own scanline.
+//The buckets are packed back to back in one arena allocation. The first pass reads the sprite arrays once, skips
+//sprites with nothing on screen and counts the runs of every row. The second fills the buckets from the short list of
+//sprites it kept, and nothing is allocated once the arena has grown to fit
+void Renderer::binSprites(const Game& game) {
+	const SpriteStore& sprites = game.sprites;
+	int rowEnds[SCREEN_HEIGHT];
+
+	struct Visible {
+		short top;
+		short bottom;
+		Span span;
+	};
+
+	arena.reset();
+	Visible* visible = arena.allocate<Visible>(sprites.size());
+	int visibleCount = 0;
+
+	for (int y = 0; y <= (int)SCREEN_HEIGHT; y++) {
+		rowStarts[y] = 0;
+	}
+
+	for (size_t i = 0; i < sprites.size(); i++) {
+		//A sprite covers the rows from y - height + 1 up to and including y, and the same for columns and x
+		int top = sprites.y[i] - sprites.height[i] + 1;
+		int bottom = sprites.y[i];
+		int left = sprites.x[i] - sprites.width[i] + 1;
+		int right = sprites.x[i];
+
+		if (top < 0) {
+			top = 0;
+		}
+		if (bottom > (int)SCREEN_HEIGHT - 1) {
+			bottom = SCREEN_HEIGHT - 1;
+		}
+
+		//x and y are unsigned, so a sprite can only hang off the top or left edge, never be past it
+		if (top > bottom || left > (int)SCREEN_WIDTH - 1 || sprites.width[i] == 0 || (sprites.flags[i] & SPRITE_HIDDEN) != 0) {
+			continue;
+		}
+
+		//Counted where the rows start and stop, the running total below turns that into runs per row
+		rowStarts[top + 1]++;
+		if (bottom + 2 <= (int)SCREEN_HEIGHT) {
+			rowStarts[bottom + 2]--;
+		}
+		visible[visibleCount++] = { (short)top, (short)bottom, { (short)left, (short)right } };
+	}
+
+	int runs = 0;
+	for (int y = 0; y < (int)SCREEN_HEIGHT; y++) {
+		runs += rowStarts[y + 1];
+		rowStarts[y + 1] = rowStarts[y] + runs;
+		rowEnds[y] = rowStarts[y];
+	}
+	spans = arena.allocate<Span>(rowStarts[SCREEN_HEIGHT]);
+
+	for (int i = 0; i < visibleCount; i++) {
+		for (int y = visible[i].top; y <= visible[i].bottom; y++) {
+			spans[rowEnds[y]++] = visible[i].span;
+		}
+	}
+}
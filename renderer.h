@@ -0,0 +1,79 @@
+#pragma once
+
+#include "damage.h"
+#include "framearena.h"
+#include "game.h"
+#include "pixelformat.h"
+#include "tilewindow.h"
+#include "workerpool.h"
+
+#include <memory>
+#include <vector>
+
+//In Spectrum format every scanline is SCREEN_WIDTH / 8 bytes with the leftmost pixel in the top bit,
+//and the attributes follow the bitmap as extra rows of one byte per cell
+static const int SPECTRUM_BITMAP_LENGTH = SCREEN_WIDTH / 8 * SCREEN_HEIGHT;
+static const int SPECTRUM_ATTRIBUTE_LENGTH = SCREEN_WIDTH / 8 * (SCREEN_HEIGHT / 8);
+
+//How a format's buffer is laid out as a texture
+struct ImageLayout {
+	int width;
+	int height;
+	int texelSize; //Bytes per texel
+};
+
+ImageLayout imageLayout(PixelFormat format);
+
+//Software renderer that paints a Game into a pixel buffer, without needing a window or GL context
+class Renderer {
+public:
+	static const int IMAGE_DATA_LENGTH = SCREEN_WIDTH * SCREEN_HEIGHT * 4; //Enough for any format, 4 because RGBA components
+
+	//With more than one thread the screen is split into horizontal bands that get painted in parallel
+	Renderer(PixelFormat format = PixelFormat::Rgba, int threads = 1);
+
+	int getImageDataLength() const;
+
+	//Paint a whole frame of the game into imageData, which has to hold getImageDataLength() bytes
+	void render(const Game& game, unsigned char* imageData);
+	//Only repaint the damaged parts, imageData has to hold an earlier frame everywhere else
+	void render(const Game& game, unsigned char* imageData, const Damage& damage);
+
+	//Work out what changed on screen since the last call, both where sprites were and where they are now
+	void findDamage(const Game& game, Damage& damage);
+	//Make the next findDamage() report the whole screen and the next render() decode every tile in view again, for
+	//when the background changes
+	void invalidate();
+
+private:
+	//Pixels left up to and including right of one row are covered by a sprite
+	struct Span {
+		short left;
+		short right;
+	};
+
+	void binSprites(const Game& game);
+	void prepareBackground(const Game& game);
+	void paintBand(int band, const Damage& damage, const Game& game, unsigned char* imageData);
+	void paintRect(const Rect& rect, const Game& game, unsigned char* imageData);
+	void fillSpan(unsigned char* pixel, int count, unsigned char color, const Palette& palette);
+	void paintRectSpectrum(const Rect& rect, const Game& game, unsigned char* imageData);
+	bool hasSprite(int cellX, int cellY) const;
+
+	PixelFormat format;
+	std::unique_ptr<WorkerPool> pool;
+	int bandCount;
+	Damage fullScreen;
+	//Sprite runs of row y are spans[rowStarts[y]] up to but not including spans[rowStarts[y + 1]], all in the
+	//arena and filled once per frame by binSprites()
+	FrameArena arena;
+	Span* spans = NULL;
+	int rowStarts[SCREEN_HEIGHT + 1];
+	std::vector<Rect> previousBounds; //Where each sprite was drawn at the last findDamage()
+	const TileMap* previousBackground = NULL; //Background and where it was scrolled to at the last findDamage()
+	int previousScrollX = 0;
+	int previousScrollY = 0;
+	TileWindow window; //The tiles in view, decoded in this format
+	bool invalidated = true;
+	unsigned int paletteVersion = 0; //Palette the RGBA pixels were painted with
+};
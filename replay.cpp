@@ -0,0 +1,199 @@
+#include "replay.h"
+#include "hash.h"
+
+#include <cstdio>
+#include <cstring>
+
+//File layout, all little endian: "A8IN", version, tick rate in millihertz, tick count, run count as 32 bit values,
+//then per run the input bits as one byte and its length as a base 128 varint. Version 2 adds a 32 bit hash count,
+//either 0 or the tick count, then a 64 bit state and frame hash per tick. Version 3 adds the background scene's path
+//as a 32 bit length and that many bytes, length 0 for none
+static const char MAGIC[4] = { 'A', '8', 'I', 'N' };
+
+static void writeUint32(std::vector<unsigned char>& out, unsigned int value) {
+	for (int i = 0; i < 4; i++) {
+		out.push_back((value >> (i * 8)) & 0xFF);
+	}
+}
+
+static void writeUint64(std::vector<unsigned char>& out, unsigned long long value) {
+	for (int i = 0; i < 8; i++) {
+		out.push_back((value >> (i * 8)) & 0xFF);
+	}
+}
+
+static bool readUint64(const std::vector<unsigned char>& in, size_t& pos, unsigned long long& value) {
+	if (pos + 8 > in.size()) {
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < 8; i++) {
+		value |= (unsigned long long)in[pos++] << (i * 8);
+	}
+	return true;
+}
+
+static bool readUint32(const std::vector<unsigned char>& in, size_t& pos, unsigned int& value) {
+	if (pos + 4 > in.size()) {
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= (unsigned int)in[pos++] << (i * 8);
+	}
+	return true;
+}
+
+unsigned char InputLog::packInput(const Input& input) {
+	return (input.left ? 1 : 0) | (input.right ? 2 : 0) | (input.up ? 4 : 0) | (input.down ? 8 : 0);
+}
+
+Input InputLog::unpackInput(unsigned char bits) {
+	Input input;
+	input.left = (bits & 1) != 0;
+	input.right = (bits & 2) != 0;
+	input.up = (bits & 4) != 0;
+	input.down = (bits & 8) != 0;
+	return input;
+}
+
+void InputLog::add(const Input& input) {
+	unsigned char bits = packInput(input);
+	if (!runs.empty() && runs.back().bits == bits && runs.back().length < 0xFFFFFFFFu) {
+		runs.back().length++;
+	}
+	else {
+		Run run;
+		run.bits = bits;
+		run.length = 1;
+		runs.push_back(run);
+	}
+	tickCount++;
+}
+
+void InputLog::addHashes(unsigned long long state, unsigned long long frame) {
+	TickHashes tickHashes;
+	tickHashes.state = state;
+	tickHashes.frame = frame;
+	hashes.push_back(tickHashes);
+}
+
+bool InputLog::save(const char* path) const {
+	std::vector<unsigned char> out(MAGIC, MAGIC + 4);
+	writeUint32(out, VERSION);
+	writeUint32(out, (unsigned int)(tickRate * 1000.0 + 0.5));
+	writeUint32(out, (unsigned int)tickCount);
+	writeUint32(out, (unsigned int)runs.size());
+
+	for (auto const& run : runs) {
+		out.push_back(run.bits);
+		unsigned int length = run.length;
+		while (length >= 0x80) {
+			out.push_back((length & 0x7F) | 0x80);
+			length >>= 7;
+		}
+		out.push_back((unsigned char)length);
+	}
+
+	//Hashes only make sense if every tick has them
+	bool withHashes = hashes.size() == tickCount;
+	writeUint32(out, withHashes ? (unsigned int)hashes.size() : 0);
+	if (withHashes) {
+		for (auto const& tickHashes : hashes) {
+			writeUint64(out, tickHashes.state);
+			writeUint64(out, tickHashes.frame);
+		}
+	}
+	writeUint32(out, (unsigned int)scene.size());
+	out.insert(out.end(), scene.begin(), scene.end());
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+	return fclose(file) == 0 && written;
+}
+
+bool InputLog::load(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	std::vector<unsigned char> in;
+	unsigned char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		in.insert(in.end(), buffer, buffer + read);
+	}
+	fclose(file);
+
+	size_t pos = 4;
+	unsigned int version, milliHertz, ticks, runCount;
+	if (in.size() < 4 || memcmp(in.data(), MAGIC, 4) != 0 || !readUint32(in, pos, version) || version < 1 || version > VERSION
+		|| !readUint32(in, pos, milliHertz) || !readUint32(in, pos, ticks) || !readUint32(in, pos, runCount)) {
+		return false;
+	}
+
+	runs.clear();
+	size_t total = 0;
+	for (unsigned int i = 0; i < runCount; i++) {
+		if (pos >= in.size()) {
+			return false;
+		}
+		Run run;
+		run.bits = in[pos++];
+		run.length = 0;
+		for (int shift = 0; ; shift += 7) {
+			if (pos >= in.size() || shift > 28) {
+				return false;
+			}
+			unsigned char byte = in[pos++];
+			run.length |= (unsigned int)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				break;
+			}
+		}
+		total += run.length;
+		runs.push_back(run);
+	}
+
+	if (total != ticks) {
+		return false;
+	}
+
+	hashes.clear();
+	unsigned int hashCount = 0;
+	if (version >= 2 && (!readUint32(in, pos, hashCount) || (hashCount != 0 && hashCount != ticks))) {
+		return false;
+	}
+	for (unsigned int i = 0; i < hashCount; i++) {
+		TickHashes tickHashes;
+		if (!readUint64(in, pos, tickHashes.state) || !readUint64(in, pos, tickHashes.frame)) {
+			return false;
+		}
+		hashes.push_back(tickHashes);
+	}
+
+	//Older logs don't say, they replay over whatever --scene is given
+	scene.clear();
+	unsigned int sceneLength = 0;
+	if (version >= 3 && (!readUint32(in, pos, sceneLength) || sceneLength > in.size() - pos)) {
+		return false;
+	}
+	scene.assign((const char*)in.data() + pos, sceneLength);
+	tickRate = milliHertz / 1000.0;
+	tickCount = total;
+	return true;
+}
+
+Recorder::Recorder(InputLog& log) : log(log), renderer(FRAME_FORMAT), imageData(renderer.getImageDataLength()) {
+}
+
+void Recorder::tick(Game& game, const Input& input) {
+	log.add(input);
+	::tick(game, input);
+
+	renderer.render(game, imageData.data());
+	log.addHashes(hashGame(game), hashBytes(imageData.data(), imageData.size()));
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "game.h"
+#include "input.h"
+#include "renderer.h"
+#include "timestep.h"
+
+#include <string>
+#include <vector>
+
+//The input of every tick of a session, enough to play it back exactly since tick() is deterministic.
+//Saved run-length encoded: consecutive ticks mostly hold the same keys. Recordings made with a Recorder also keep
+//hashes of the state and picture after every tick, so a replay can point at the first tick that came out different.
+//The picture includes the background, so the log names the scene it was recorded over
+class InputLog {
+public:
+	static const unsigned int VERSION = 3;
+
+	struct TickHashes {
+		unsigned long long state; //hashGame() after the tick
+		unsigned long long frame; //A full RGBA render of that state
+	};
+
+	InputLog(double tickRate = 0.0) : tickRate(tickRate), tickCount(0) {}
+
+	void add(const Input& input);
+	void addHashes(unsigned long long state, unsigned long long frame);
+	//One per tick, or empty for recordings without them
+	const std::vector<TickHashes>& getHashes() const { return hashes; }
+	size_t getTickCount() const { return tickCount; }
+	double getTickRate() const { return tickRate; }
+	//Path of the background scene the session was played over, empty for none
+	void setScene(const std::string& path) { scene = path; }
+	const std::string& getScene() const { return scene; }
+
+	//Calls visit(input) once per tick, in order
+	template <typename Visitor>
+	void forEachTick(Visitor visit) const {
+		for (auto const& run : runs) {
+			Input input = unpackInput(run.bits);
+			for (unsigned int i = 0; i < run.length; i++) {
+				visit(input);
+			}
+		}
+	}
+
+	bool save(const char* path) const;
+	bool load(const char* path);
+
+	static unsigned char packInput(const Input& input);
+	static Input unpackInput(unsigned char bits);
+
+private:
+	struct Run {
+		unsigned char bits;
+		unsigned int length;
+	};
+
+	double tickRate; //What the session ran at, for reporting how long it lasted
+	size_t tickCount;
+	std::string scene;
+	std::vector<Run> runs;
+	std::vector<TickHashes> hashes;
+};
+
+//Ticks the game for a recording session and adds the tick, with its hashes, to the log
+class Recorder {
+public:
+	Recorder(InputLog& log);
+
+	void tick(Game& game, const Input& input);
+
+	//What the frame hashes are taken of, so replays can hash the same thing
+	static const PixelFormat FRAME_FORMAT = PixelFormat::Rgba;
+
+private:
+	InputLog& log;
+	Renderer renderer;
+	std::vector<unsigned char> imageData;
+};
+
+//Runs the ticks that fell due between last and now, each one only seeing the key events from before its own time, and
+//moves last on to now. previous is left holding the state before the last tick, for interpolating. Ticks go through
+//recorder when there is one. inputSeen(time) is called with the oldest key event of every tick that took any
+template <typename InputVisitor>
+int runTicks(FixedTimestep& timestep, InputQueue& inputs, unsigned long long now, unsigned long long& last, Game& game,
+	Game& previous, Recorder* recorder, InputVisitor inputSeen) {
+	int ticks = timestep.advance((now - last) / 1e9);
+	last = now;
+
+	for (int i = 0; i < ticks; i++) {
+		Input input = inputs.takeTick(now - (unsigned long long)(timestep.getTickAge(i, ticks) * 1e9));
+		if (inputs.getOldestEventTime() != 0) {
+			inputSeen(inputs.getOldestEventTime());
+		}
+
+		previous = game;
+		if (recorder != NULL) {
+			recorder->tick(game, input);
+		}
+		else {
+			tick(game, input);
+		}
+	}
+	return ticks;
+}
@@ -0,0 +1,262 @@
+#include "screentexture.h"
+#include "game.h"
+
+#include <cstring>
+#include <iostream>
+
+const char* uploadModeName(UploadMode mode) {
+	switch (mode) {
+	case UploadMode::Legacy: return "legacy";
+	case UploadMode::SubImage: return "sub-image";
+	case UploadMode::Streaming: return "streaming";
+	}
+	return "unknown";
+}
+
+ScreenTexture::ScreenTexture(UploadMode mode, PixelFormat format)
+	: mode(mode), imageData(NULL), persistent(false), current(0), damagedPixels(0), bytesUploaded(0) {
+	layout = imageLayout(format);
+	imageDataLength = layout.width * layout.height * layout.texelSize;
+	wholeUploads = format == PixelFormat::Spectrum;
+	staged = format == PixelFormat::Spectrum;
+
+	//Indexed pixels and Spectrum bytes end up in the red channel, where the fragment shader picks them up
+	if (layout.texelSize == 1) {
+		internalFormat = GL_R8;
+		pixelFormat = GL_RED;
+	}
+	else {
+		internalFormat = GL_RGBA8;
+		pixelFormat = GL_RGBA;
+	}
+
+	for (int i = 0; i < RING_SIZE; i++) {
+		pixelBuffers[i] = 0;
+		mappedBuffers[i] = NULL;
+		fences[i] = NULL;
+		pending[i].addScreen(); //Nothing has been painted into any buffer yet
+	}
+	uploadDamage.addScreen();
+	fullScreen.addScreen();
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// set the texture wrapping/filtering options (on the currently bound texture object)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	//Rows inside a damaged rectangle are a whole screen width apart in the source
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, layout.width);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	//Allocate the texture once, every frame after that only overwrites its pixels. We sample with GL_NEAREST so one level is enough
+	if (mode != UploadMode::Legacy) {
+		if (GLAD_GL_VERSION_4_2) {
+			glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, layout.width, layout.height);
+		}
+		else {
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, layout.width, layout.height, 0, pixelFormat, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		}
+	}
+
+	if (this->mode == UploadMode::Streaming) {
+		initStreaming();
+	}
+
+	if (this->mode != UploadMode::Streaming || staged) {
+		//No need to initialize it, the whole screen is damaged until the first frame is painted
+		imageData = new unsigned char[imageDataLength];
+	}
+}
+
+ScreenTexture::~ScreenTexture() {
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (fences[i] != NULL) {
+			glDeleteSync(fences[i]);
+		}
+	}
+
+	if (pixelBuffers[0] != 0) {
+		if (persistent) {
+			for (int i = 0; i < RING_SIZE; i++) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[i]);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		glDeleteBuffers(RING_SIZE, pixelBuffers);
+	}
+
+	glDeleteTextures(1, &texture);
+	delete[] imageData;
+}
+
+void ScreenTexture::initStreaming() {
+	glGenBuffers(RING_SIZE, pixelBuffers);
+
+	//With buffer storage every buffer stays mapped for the whole run, otherwise we map it again each frame
+	persistent = GLAD_GL_VERSION_4_4 != 0;
+
+	for (int i = 0; i < RING_SIZE; i++) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[i]);
+
+		if (persistent) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, imageDataLength, NULL, flags);
+			mappedBuffers[i] = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageDataLength, flags);
+
+			if (mappedBuffers[i] == NULL) {
+				std::cout << "ERROR::SCREENTEXTURE::PERSISTENT_MAP_FAILED" << std::endl;
+			}
+		}
+		else {
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, imageDataLength, NULL, GL_STREAM_DRAW);
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (persistent && mappedBuffers[i] == NULL) {
+			std::cout << "Falling back to sub-image uploads" << std::endl;
+			glDeleteBuffers(RING_SIZE, pixelBuffers);
+			for (int j = 0; j < RING_SIZE; j++) {
+				pixelBuffers[j] = 0;
+				mappedBuffers[j] = NULL;
+			}
+			mode = UploadMode::SubImage;
+			return;
+		}
+	}
+}
+
+//Block until the GPU has finished copying out of the buffer, so we never paint over pixels it still reads
+void ScreenTexture::waitForBuffer(int index) {
+	if (fences[index] == NULL) {
+		return;
+	}
+
+	GLenum result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fences[index], 0, 1000000000);
+	}
+
+	glDeleteSync(fences[index]);
+	fences[index] = NULL;
+}
+
+unsigned char* ScreenTexture::beginFrame(const Damage& damage) {
+	if (mode == UploadMode::Legacy) {
+		uploadDamage.addScreen();
+	}
+	else {
+		uploadDamage.addAll(damage);
+	}
+
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (mode == UploadMode::Legacy) {
+			pending[i].addScreen();
+		}
+		else {
+			pending[i].addAll(damage);
+		}
+	}
+
+	if (mode != UploadMode::Streaming || staged) {
+		return imageData;
+	}
+
+	return mapCurrent();
+}
+
+//Wait until the GPU is done with the current ring buffer and map it, unless it stays mapped for good
+unsigned char* ScreenTexture::mapCurrent() {
+	waitForBuffer(current);
+
+	if (persistent) {
+		return mappedBuffers[current];
+	}
+
+	//The fence already told us the GPU is done with this buffer, so there is nothing for the driver to synchronise on.
+	//We don't invalidate it either, the parts outside the damage still hold a frame we want to keep
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[current]);
+	mappedBuffers[current] = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, imageDataLength,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	return mappedBuffers[current];
+}
+
+void ScreenTexture::endFrame() {
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	damagedPixels = uploadDamage.getPixelCount();
+	bytesUploaded = 0;
+
+	if (mode == UploadMode::Legacy) {
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, layout.width, layout.height, 0, pixelFormat, GL_UNSIGNED_BYTE, imageData);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		bytesUploaded = imageDataLength;
+	}
+	else if (mode == UploadMode::SubImage) {
+		upload(imageData);
+	}
+	else {
+		if (staged) {
+			memcpy(mapCurrent(), imageData, imageDataLength);
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[current]);
+		if (!persistent) {
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			mappedBuffers[current] = NULL;
+		}
+
+		//With a pixel buffer bound the pointers are offsets into it, and the copy happens on the GPU timeline
+		upload((const unsigned char*)0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	//A staged frame stays whole in imageData, so only what changes after this has to be painted again
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (staged || i == current) {
+			pending[i].clear();
+		}
+	}
+	uploadDamage.clear();
+
+	if (mode == UploadMode::Streaming) {
+		current = (current + 1) % RING_SIZE;
+	}
+}
+
+//Copy every damaged rectangle from pixels into the texture, which is one call when the damage covers the screen
+void ScreenTexture::upload(const unsigned char* pixels) {
+	//A whole Spectrum screen is smaller than most damaged rectangles in the other formats, so it always goes in one piece
+	if (wholeUploads) {
+		if (!uploadDamage.isEmpty()) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, layout.width, layout.height, pixelFormat, GL_UNSIGNED_BYTE, pixels);
+			bytesUploaded += imageDataLength;
+		}
+		return;
+	}
+
+	for (auto const& rect : uploadDamage.getRects()) {
+		const unsigned char* source = pixels + (rect.y * layout.width + rect.x) * layout.texelSize;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, pixelFormat, GL_UNSIGNED_BYTE, source);
+		bytesUploaded += rect.width * rect.height * layout.texelSize;
+	}
+}
+
+void ScreenTexture::present(const unsigned char* pixels) {
+	memcpy(beginFrame(fullScreen), pixels, imageDataLength);
+	endFrame();
+}
+
+void ScreenTexture::bind() {
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
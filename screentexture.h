@@ -0,0 +1,70 @@
+#pragma once
+
+#include "damage.h"
+#include "renderer.h"
+
+#include <glad/glad.h>
+
+enum class UploadMode {
+	Legacy,    //glTexImage2D + glGenerateMipmap every frame, only kept for comparing timings
+	SubImage,  //Texture allocated once, glTexSubImage2D from a CPU buffer every frame
+	Streaming  //Paint straight into a ring of pixel buffer objects that the GPU copies from asynchronously
+};
+
+const char* uploadModeName(UploadMode mode);
+
+//The texture the screen is drawn from, and the buffer the renderer paints into before it gets there
+class ScreenTexture {
+public:
+	static const int RING_SIZE = 3;
+
+	ScreenTexture(UploadMode mode, PixelFormat format);
+	~ScreenTexture();
+
+	//The buffer to paint this frame's pixels into, valid until endFrame(). damage is what changed since the last frame
+	unsigned char* beginFrame(const Damage& damage);
+	//What has to be repainted in the buffer from beginFrame(). Ring buffers hold older frames, so this can be more than this frame's damage
+	const Damage& getRepaint() const { return pending[current]; }
+	//Hand the painted pixels over to GL, only uploading the damaged parts. In streaming mode this returns before the copy has happened
+	void endFrame();
+
+	//Upload a whole frame painted somewhere else, like on the pipeline's render thread
+	void present(const unsigned char* pixels);
+
+	void bind();
+	UploadMode getMode() const { return mode; }
+
+	//Counters for the last frame
+	int getDamagedPixels() const { return damagedPixels; }
+	int getBytesUploaded() const { return bytesUploaded; }
+
+private:
+	void initStreaming();
+	void waitForBuffer(int index);
+	unsigned char* mapCurrent();
+	void upload(const unsigned char* pixels);
+
+	UploadMode mode;
+	unsigned int texture;
+	GLenum internalFormat;
+	GLenum pixelFormat;
+	ImageLayout layout;
+	int imageDataLength;
+	bool wholeUploads; //Skip the damaged rectangles and upload everything whenever anything changed
+	//Painting Spectrum bytes reads them back, which a write only mapping can't do, so those frames are painted here
+	//and copied into the ring whole
+	bool staged;
+	unsigned char* imageData; //CPU side buffer for the non streaming modes, and for staged frames
+
+	bool persistent; //Whether the ring is mapped once for good (GL 4.4) or mapped every frame
+	unsigned int pixelBuffers[RING_SIZE];
+	unsigned char* mappedBuffers[RING_SIZE];
+	GLsync fences[RING_SIZE]; //Signalled once the GPU is done copying out of the matching buffer
+	int current;
+
+	Damage pending[RING_SIZE]; //Per buffer, everything that changed since it was last painted
+	Damage uploadDamage; //What changed since the texture was last updated
+	Damage fullScreen;
+	int damagedPixels;
+	int bytesUploaded;
+};
@@ -0,0 +1,85 @@
+#include "spritestore.h"
+
+SpriteHandle SpriteStore::add(unsigned char x, unsigned char y, unsigned char width, unsigned char height) {
+	SpriteHandle handle;
+
+	if (freeSlots.empty()) {
+		handle.slot = (unsigned int)generations.size();
+		generations.push_back(1);
+		slotIndices.push_back(0);
+	}
+	else {
+		handle.slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	handle.generation = generations[handle.slot];
+	slotIndices[handle.slot] = (unsigned int)handles.size();
+
+	handles.push_back(handle);
+	this->x.push_back(x);
+	this->y.push_back(y);
+	this->width.push_back(width);
+	this->height.push_back(height);
+	image.push_back(0);
+	flags.push_back(0);
+
+	return handle;
+}
+
+bool SpriteStore::remove(SpriteHandle handle) {
+	size_t index = indexOf(handle);
+	if (index == NOT_FOUND) {
+		return false;
+	}
+
+	//Move the last sprite into the hole
+	size_t last = handles.size() - 1;
+	handles[index] = handles[last];
+	x[index] = x[last];
+	y[index] = y[last];
+	width[index] = width[last];
+	height[index] = height[last];
+	image[index] = image[last];
+	flags[index] = flags[last];
+	slotIndices[handles[index].slot] = (unsigned int)index;
+
+	handles.pop_back();
+	x.pop_back();
+	y.pop_back();
+	width.pop_back();
+	height.pop_back();
+	image.pop_back();
+	flags.pop_back();
+
+	//Skip 0 when the counter wraps, that generation means no sprite
+	if (++generations[handle.slot] == 0) {
+		generations[handle.slot] = 1;
+	}
+	freeSlots.push_back(handle.slot);
+
+	return true;
+}
+
+void SpriteStore::clear() {
+	for (auto const& handle : handles) {
+		if (++generations[handle.slot] == 0) {
+			generations[handle.slot] = 1;
+		}
+		freeSlots.push_back(handle.slot);
+	}
+
+	handles.clear();
+	x.clear();
+	y.clear();
+	width.clear();
+	height.clear();
+	image.clear();
+	flags.clear();
+}
+
+size_t SpriteStore::indexOf(SpriteHandle handle) const {
+	if (handle.slot >= generations.size() || generations[handle.slot] != handle.generation) {
+		return NOT_FOUND;
+	}
+	return slotIndices[handle.slot];
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//Bits of SpriteStore::flags
+static const unsigned char SPRITE_HIDDEN = 1; //Still ticks and moves, but is not drawn
+
+//Names a sprite for as long as it lives. Every time a slot is reused its generation goes up,
+//so a handle to a removed sprite stops finding anything instead of finding whatever took its place
+struct SpriteHandle {
+	unsigned int slot = 0;
+	unsigned int generation = 0; //Never 0 for a live sprite, so a default handle finds nothing
+
+	bool operator==(const SpriteHandle& other) const { return slot == other.slot && generation == other.generation; }
+	bool operator!=(const SpriteHandle& other) const { return !(*this == other); }
+};
+
+//Sprites kept as one tightly packed array per field rather than one struct per sprite, so loops that only need
+//positions read nothing else. Removing moves the last sprite into the hole, which keeps the arrays dense but means
+//a sprite's index can change, so hold on to its handle and look the index up with indexOf()
+class SpriteStore {
+public:
+	static const size_t NOT_FOUND = (size_t)-1;
+
+	//A sprite covers x - width + 1 up to and including x, and the same for y and height
+	SpriteHandle add(unsigned char x, unsigned char y, unsigned char width = 9, unsigned char height = 9);
+	//False if the handle was already removed
+	bool remove(SpriteHandle handle);
+	void clear();
+
+	size_t indexOf(SpriteHandle handle) const; //NOT_FOUND once removed
+	bool contains(SpriteHandle handle) const { return indexOf(handle) != NOT_FOUND; }
+	size_t size() const { return handles.size(); }
+	const std::vector<SpriteHandle>& getHandles() const { return handles; } //Handle of the sprite at every index
+
+	//Sprite i is at index i of each of these. Change the values freely, but only add and remove sprites
+	//through the store so the arrays stay the same length
+	std::vector<unsigned char> x;
+	std::vector<unsigned char> y;
+	std::vector<unsigned char> width;
+	std::vector<unsigned char> height;
+	std::vector<unsigned char> image; //Which picture to draw, every sprite is the plain green square for now
+	std::vector<unsigned char> flags;
+
+private:
+	std::vector<SpriteHandle> handles;
+	std::vector<unsigned int> slotIndices; //Index of the sprite in every slot
+	std::vector<unsigned int> generations; //Current generation of every slot
+	std::vector<unsigned int> freeSlots;
+};
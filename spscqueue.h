@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//Bounded lock-free queue for exactly one producer thread and one consumer thread. push() and pop() never block,
+//pushWait() and popWait() sleep on a condition variable until there is room or something to take. The lock is only
+//taken by a thread about to sleep and by the other side when someone is sleeping
+template <typename T>
+class SpscQueue {
+public:
+	SpscQueue(size_t capacity) : slots(capacity + 1), head(0), tail(0), sleepers(0), closed(false) {
+	}
+
+	//Returns false instead of waiting when the queue is full
+	bool push(T&& value) {
+		size_t current = tail.load(std::memory_order_relaxed);
+		size_t next = (current + 1) % slots.size();
+		if (next == head.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		slots[current] = std::move(value);
+		tail.store(next, std::memory_order_release);
+		wakeSleepers();
+		return true;
+	}
+
+	//Returns false instead of waiting when the queue is empty
+	bool pop(T& value) {
+		size_t current = head.load(std::memory_order_relaxed);
+		if (current == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		value = std::move(slots[current]);
+		head.store((current + 1) % slots.size(), std::memory_order_release);
+		wakeSleepers();
+		return true;
+	}
+
+	//Waits while the queue is full. Returns false without pushing once the queue is closed
+	bool pushWait(T&& value) {
+		while (!push(std::move(value))) {
+			if (!sleepUntil([this] { return (tail.load(std::memory_order_acquire) + 1) % slots.size() != head.load(std::memory_order_acquire); })) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Waits while the queue is empty. Returns false without popping once the queue is closed
+	bool popWait(T& value) {
+		while (!pop(value)) {
+			if (!sleepUntil([this] { return head.load(std::memory_order_acquire) != tail.load(std::memory_order_acquire); })) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Wake anyone waiting and make every wait from now on fail, for shutting down
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		wakeup.notify_all();
+	}
+
+private:
+	//Sleep until ready() or close(). A sleeper is counted before it looks at the queue, and push() and pop() look at
+	//the count after they change it, with a full fence in between on both sides. So either the sleeper sees the
+	//change, or the other side sees the sleeper and wakes it under the lock it holds until it is waiting
+	template <typename Ready>
+	bool sleepUntil(Ready ready) {
+		std::unique_lock<std::mutex> lock(mutex);
+		sleepers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		wakeup.wait(lock, [&] { return closed || ready(); });
+		sleepers.fetch_sub(1);
+		return !closed;
+	}
+
+	void wakeSleepers() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers.load(std::memory_order_relaxed) > 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			wakeup.notify_all();
+		}
+	}
+
+	std::vector<T> slots; //One slot always stays empty to tell a full queue from an empty one
+	std::atomic<size_t> head; //Only written by the consumer
+	char padding[64]; //Keeps head and tail off the same cache line, without alignas which plain new can't honour before C++17
+	std::atomic<size_t> tail; //Only written by the producer
+	std::atomic<int> sleepers;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	bool closed;
+};
@@ -0,0 +1,135 @@
+#include "tilemap.h"
+#include "bmp.h"
+#include "hash.h"
+
+#include <cstring>
+#include <utility>
+
+//Copy a tile into destination, flipped the way flags say
+static void flipTile(const unsigned char* source, unsigned char flags, unsigned char* destination) {
+	for (int y = 0; y < TILE_SIZE; y++) {
+		int fromY = (flags & TILE_FLIP_Y) != 0 ? TILE_SIZE - 1 - y : y;
+		for (int x = 0; x < TILE_SIZE; x++) {
+			int fromX = (flags & TILE_FLIP_X) != 0 ? TILE_SIZE - 1 - x : x;
+			destination[y * TILE_SIZE + x] = source[fromY * TILE_SIZE + fromX];
+		}
+	}
+}
+
+TileRef TileSet::add(const unsigned char* source, int pitch) {
+	unsigned char tile[TILE_PIXELS];
+	for (int y = 0; y < TILE_SIZE; y++) {
+		memcpy(tile + y * TILE_SIZE, source + y * pitch, TILE_SIZE);
+	}
+
+	//Flipping is its own inverse, so if the new tile flipped is one we have, that one flipped the same way is the new tile
+	for (unsigned char flags = 0; flags < 4; flags++) {
+		unsigned char flipped[TILE_PIXELS];
+		flipTile(tile, flags, flipped);
+
+		auto matches = tilesByHash.equal_range(hashBytes(flipped, TILE_PIXELS));
+		for (auto match = matches.first; match != matches.second; ++match) {
+			if (memcmp(pixels.data() + match->second * TILE_PIXELS * 2, flipped, TILE_PIXELS) == 0) {
+				return { match->second, flags };
+			}
+		}
+	}
+
+	unsigned short index = (unsigned short)size();
+	tilesByHash.emplace(hashBytes(tile, TILE_PIXELS), index);
+
+	unsigned char mirrored[TILE_PIXELS];
+	flipTile(tile, TILE_FLIP_X, mirrored);
+	pixels.insert(pixels.end(), tile, tile + TILE_PIXELS);
+	pixels.insert(pixels.end(), mirrored, mirrored + TILE_PIXELS);
+
+	//Most common colour as paper and the next one as ink to start with
+	int counts[PALETTE_SIZE] = {};
+	for (int i = 0; i < TILE_PIXELS; i++) {
+		counts[tile[i] % PALETTE_SIZE]++;
+	}
+	int paper = 0;
+	for (int i = 1; i < PALETTE_SIZE; i++) {
+		if (counts[i] > counts[paper]) {
+			paper = i;
+		}
+	}
+	int ink = paper;
+	for (int i = 0; i < PALETTE_SIZE; i++) {
+		if (i != paper && counts[i] > 0 && (ink == paper || counts[i] > counts[ink])) {
+			ink = i;
+		}
+	}
+
+	//Black is paper whenever it is one of the two, so set bits mean the picture rather than the background in every
+	//tile, and a cell scrolled part way across two tiles still shows the shapes of both
+	if (ink % PALETTE_BRIGHT == PALETTE_BLACK) {
+		std::swap(ink, paper);
+	}
+
+	//One bright bit covers both, so the ink decides
+	attributes.push_back((ink >= PALETTE_BRIGHT ? 0x40 : 0) | (paper % PALETTE_BRIGHT) << 3 | ink % PALETTE_BRIGHT);
+
+	for (int mirror = 0; mirror < 2; mirror++) {
+		const unsigned char* rows = mirror == 0 ? tile : mirrored;
+		for (int y = 0; y < TILE_SIZE; y++) {
+			unsigned char row = 0;
+			for (int x = 0; x < TILE_SIZE; x++) {
+				row = row << 1 | (rows[y * TILE_SIZE + x] != paper ? 1 : 0);
+			}
+			bits.push_back(row);
+		}
+	}
+
+	return { index, 0 };
+}
+
+bool TileMap::load(const char* path, const Palette& palette, int repeat) {
+	BmpFile file;
+	if (repeat < 1 || !file.open(path)) {
+		return false;
+	}
+
+	int width = file.getWidth();
+	int height = file.getHeight();
+	int pitch = width * repeat;
+	std::vector<unsigned char> indices(pitch * height * repeat);
+	file.toIndexed(indices.data(), pitch, palette);
+
+	//Copies flipped one way or the other are the same tiles, so a bigger map only adds cells
+	for (int copyY = 0; copyY < repeat; copyY++) {
+		for (int copyX = 0; copyX < repeat; copyX++) {
+			if (copyX == 0 && copyY == 0) {
+				continue;
+			}
+			for (int y = 0; y < height; y++) {
+				const unsigned char* from = indices.data() + (copyY % 2 == 0 ? y : height - 1 - y) * pitch;
+				unsigned char* to = indices.data() + (copyY * height + y) * pitch + copyX * width;
+				for (int x = 0; x < width; x++) {
+					to[x] = from[copyX % 2 == 0 ? x : width - 1 - x];
+				}
+			}
+		}
+	}
+
+	return build(indices.data(), pitch, height * repeat, pitch);
+}
+
+bool TileMap::build(const unsigned char* indices, int width, int height, int pitch) {
+	if (width <= 0 || height <= 0 || width % TILE_SIZE != 0 || height % TILE_SIZE != 0) {
+		return false;
+	}
+
+	tiles = TileSet();
+	columns = width / TILE_SIZE;
+	rows = height / TILE_SIZE;
+	cells.resize(columns * rows);
+
+	for (int row = 0; row < rows; row++) {
+		for (int column = 0; column < columns; column++) {
+			cells[row * columns + column] = tiles.add(indices + row * TILE_SIZE * pitch + column * TILE_SIZE, pitch);
+		}
+	}
+
+	return true;
+}
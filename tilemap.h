@@ -0,0 +1,78 @@
+#pragma once
+
+#include "palette.h"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+static const int TILE_SIZE = 8; //Tiles are square, and line up with the Spectrum's attribute cells
+
+//Bits of TileRef::flags
+static const unsigned char TILE_FLIP_X = 1;
+static const unsigned char TILE_FLIP_Y = 2;
+
+//Which tile goes in a map cell, and which way round
+struct TileRef {
+	unsigned short tile;
+	unsigned char flags;
+};
+
+//8x8 pictures of palette indices, none of them the same as another or a flipped version of another. Every tile is
+//kept mirrored as well, so a row of it can always be copied whole whichever way round it is drawn
+class TileSet {
+public:
+	//The tile already in the set that gives these pixels, flipped if needed, or a new one
+	TileRef add(const unsigned char* pixels, int pitch);
+
+	size_t size() const { return attributes.size(); }
+	size_t getByteCount() const { return pixels.size() + bits.size() + attributes.size(); }
+
+	//Row y of a tile drawn the way ref says, as TILE_SIZE palette indices
+	const unsigned char* getRow(TileRef ref, int y) const {
+		return pixels.data() + ((size_t)ref.tile * 2 + (ref.flags & TILE_FLIP_X)) * TILE_PIXELS + flipRow(ref, y) * TILE_SIZE;
+	}
+
+	//Row y as Spectrum ink bits, the leftmost pixel in the top bit
+	unsigned char getBits(TileRef ref, int y) const {
+		return bits[((size_t)ref.tile * 2 + (ref.flags & TILE_FLIP_X)) * TILE_SIZE + flipRow(ref, y)];
+	}
+	//Spectrum attribute, the most common colour as paper and the next as ink, but black is always paper if it is one of
+	//them. Any other colours turn into ink too
+	unsigned char getAttribute(TileRef ref) const { return attributes[ref.tile]; }
+
+private:
+	static const int TILE_PIXELS = TILE_SIZE * TILE_SIZE;
+
+	//TILE_SIZE - 1 - y, written as y ^ 7 since TILE_SIZE is 8
+	static int flipRow(TileRef ref, int y) { return y ^ ((ref.flags & TILE_FLIP_Y) != 0 ? TILE_SIZE - 1 : 0); }
+
+	std::vector<unsigned char> pixels; //Every tile, then the same tile mirrored
+	std::vector<unsigned char> bits; //Every tile as one byte per row, then mirrored
+	std::vector<unsigned char> attributes;
+	std::unordered_multimap<unsigned long long, unsigned short> tilesByHash; //Only used while adding
+};
+
+//A picture cut into tiles, which keeps every different tile once and a map of which tile goes where
+class TileMap {
+public:
+	//A BMP whose width and height are whole tiles, with every pixel turned into the closest palette colour. With a
+	//repeat above 1 the picture is laid out that many times each way, every other copy mirrored so the edges meet
+	bool load(const char* path, const Palette& palette, int repeat = 1);
+	//Palette indices, width and height whole tiles
+	bool build(const unsigned char* indices, int width, int height, int pitch);
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	const TileRef& getTile(int column, int row) const { return cells[row * columns + column]; }
+	const TileSet& getTileSet() const { return tiles; }
+
+	//Bytes for the tiles and the map, against width * height for the picture as palette indices
+	size_t getByteCount() const { return tiles.getByteCount() + cells.size() * sizeof(TileRef); }
+
+private:
+	TileSet tiles;
+	std::vector<TileRef> cells;
+	int columns = 0;
+	int rows = 0;
+};
@@ -0,0 +1,143 @@
+#include "tilewindow.h"
+
+#include <cstdlib>
+#include <cstring>
+
+//Past the edge of the map is bright black paper, the same as the screen looks without a background
+static const unsigned char OUTSIDE_ATTRIBUTE = 0x40 | (PALETTE_BLACK << 3) | PALETTE_BLACK;
+
+//Division that rounds down for negative numbers as well, so every pixel of a tile left of the map gives the same tile
+static int floorDivide(int value, int divisor) {
+	int quotient = value / divisor;
+	return value % divisor < 0 ? quotient - 1 : quotient;
+}
+
+TileWindow::TileWindow(PixelFormat format) : format(format) {
+	pixelSize = format == PixelFormat::Rgba ? 4 : 1;
+	if (format == PixelFormat::Spectrum) {
+		bits.resize(HEIGHT * COLUMNS);
+		attributes.resize(ROWS * COLUMNS);
+	}
+	else {
+		pixels.resize(WIDTH * HEIGHT * pixelSize);
+	}
+}
+
+int TileWindow::update(const TileMap& map, int scrollX, int scrollY, const Palette& palette) {
+	int column = floorDivide(scrollX, TILE_SIZE);
+	int row = floorDivide(scrollY, TILE_SIZE);
+
+	//Palette indices and Spectrum bits stay the same whatever the colours are
+	bool recolored = format == PixelFormat::Rgba && palette.version != paletteVersion;
+	if (&map != decodedMap || recolored || abs(column - firstColumn) >= COLUMNS || abs(row - firstRow) >= ROWS) {
+		decodedMap = &map;
+		paletteVersion = palette.version;
+		firstColumn = column;
+		firstRow = row;
+		for (int y = 0; y < ROWS; y++) {
+			decodeRow(map, row + y, palette);
+		}
+		return COLUMNS * ROWS;
+	}
+
+	//Columns that came into view go over the ones that left, for the rows the window has now. Rows that came into view
+	//then get the columns the window has after that
+	int decoded = abs(column - firstColumn) * ROWS + abs(row - firstRow) * COLUMNS;
+	for (; firstColumn < column; firstColumn++) {
+		decodeColumn(map, firstColumn + COLUMNS, palette);
+	}
+	while (firstColumn > column) {
+		decodeColumn(map, --firstColumn, palette);
+	}
+	for (; firstRow < row; firstRow++) {
+		decodeRow(map, firstRow + ROWS, palette);
+	}
+	while (firstRow > row) {
+		decodeRow(map, --firstRow, palette);
+	}
+	return decoded;
+}
+
+void TileWindow::invalidate() {
+	decodedMap = NULL;
+}
+
+void TileWindow::copyRow(int x, int y, int count, unsigned char* destination) const {
+	const unsigned char* row = pixels.data() + wrap(y, HEIGHT) * WIDTH * pixelSize;
+	int from = wrap(x, WIDTH);
+	int first = count < WIDTH - from ? count : WIDTH - from;
+
+	memcpy(destination, row + from * pixelSize, first * pixelSize);
+	memcpy(destination + first * pixelSize, row, (count - first) * pixelSize);
+}
+
+void TileWindow::copyBits(int x, int y, int count, unsigned char* destination) const {
+	const unsigned char* row = bits.data() + wrap(y, HEIGHT) * COLUMNS;
+	int bit = wrap(x, WIDTH);
+	int byte = bit / 8;
+	int shift = bit % 8;
+
+	//Each byte is the end of one window byte and the start of the next. Shifting the next one right by 8 when x is on
+	//a byte boundary leaves nothing of it, as it is an int by then
+	unsigned int current = row[byte];
+	for (int i = 0; i < count; i++) {
+		byte = byte + 1 < COLUMNS ? byte + 1 : 0;
+		unsigned int next = row[byte];
+		destination[i] = (unsigned char)(current << shift | next >> (8 - shift));
+		current = next;
+	}
+}
+
+void TileWindow::copyAttributes(int x, int y, int count, unsigned char* destination) const {
+	const unsigned char* row = attributes.data() + wrap(y, HEIGHT) / TILE_SIZE * COLUMNS;
+	int column = wrap(x, WIDTH) / TILE_SIZE;
+
+	for (int i = 0; i < count; i++) {
+		destination[i] = row[column];
+		column = column + 1 < COLUMNS ? column + 1 : 0;
+	}
+}
+
+void TileWindow::decodeColumn(const TileMap& map, int column, const Palette& palette) {
+	for (int row = firstRow; row < firstRow + ROWS; row++) {
+		decodeTile(map, column, row, palette);
+	}
+}
+
+void TileWindow::decodeRow(const TileMap& map, int row, const Palette& palette) {
+	for (int column = firstColumn; column < firstColumn + COLUMNS; column++) {
+		decodeTile(map, column, row, palette);
+	}
+}
+
+//Write a tile of the map into the place in the window its pixels wrap round to
+void TileWindow::decodeTile(const TileMap& map, int column, int row, const Palette& palette) {
+	int windowColumn = wrap(column, COLUMNS);
+	int windowY = wrap(row, ROWS) * TILE_SIZE;
+	bool inside = column >= 0 && column < map.getColumns() && row >= 0 && row < map.getRows();
+	const TileSet& tiles = map.getTileSet();
+	TileRef tile = inside ? map.getTile(column, row) : TileRef();
+
+	if (format == PixelFormat::Spectrum) {
+		for (int y = 0; y < TILE_SIZE; y++) {
+			bits[(windowY + y) * COLUMNS + windowColumn] = inside ? tiles.getBits(tile, y) : 0;
+		}
+		attributes[windowY / TILE_SIZE * COLUMNS + windowColumn] = inside ? tiles.getAttribute(tile) : OUTSIDE_ATTRIBUTE;
+		return;
+	}
+
+	for (int y = 0; y < TILE_SIZE; y++) {
+		unsigned char* pixel = pixels.data() + ((windowY + y) * WIDTH + windowColumn * TILE_SIZE) * pixelSize;
+		const unsigned char* indices = inside ? tiles.getRow(tile, y) : NULL;
+
+		for (int x = 0; x < TILE_SIZE; x++) {
+			unsigned char index = inside ? indices[x] : (unsigned char)PALETTE_BLACK;
+			if (format == PixelFormat::Indexed) {
+				pixel[x] = index;
+			}
+			else {
+				memcpy(pixel + x * 4, palette.colors[index], 4);
+			}
+		}
+	}
+}
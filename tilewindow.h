@@ -0,0 +1,57 @@
+#pragma once
+
+#include "game.h"
+#include "palette.h"
+#include "pixelformat.h"
+#include "tilemap.h"
+
+#include <vector>
+
+//The tiles of a TileMap the view can see, decoded into the pixels of one format. It is a tile bigger than the screen
+//each way, since a view that isn't lined up with the tiles shows part of one more, and wraps around both ways: map
+//pixel x, y is kept at x % WIDTH, y % HEIGHT. Scrolling only decodes the tiles that came into view, over the ones that
+//went out of it, and nothing already decoded moves, so a scroll step costs the same however big the map is
+class TileWindow {
+public:
+	static const int COLUMNS = SCREEN_WIDTH / TILE_SIZE + 1;
+	static const int ROWS = SCREEN_HEIGHT / TILE_SIZE + 1;
+	static const int WIDTH = COLUMNS * TILE_SIZE;
+	static const int HEIGHT = ROWS * TILE_SIZE;
+
+	explicit TileWindow(PixelFormat format);
+
+	//Decode what a view with its top left at map pixel scrollX, scrollY shows and return how many tiles that took.
+	//Another map, another palette in RGBA or a jump further than the window decodes all of it again
+	int update(const TileMap& map, int scrollX, int scrollY, const Palette& palette);
+	//Decode the whole window at the next update()
+	void invalidate();
+
+	//Copy count pixels of map row y from x on, in two parts when they run past the end of the window. count can't be
+	//more than WIDTH
+	void copyRow(int x, int y, int count, unsigned char* destination) const;
+	//Spectrum ink bits of count bytes of map row y from x on, 8 pixels a byte with the leftmost in the top bit
+	void copyBits(int x, int y, int count, unsigned char* destination) const;
+	//Spectrum attributes of count tiles side by side, the first one under map pixel x, y
+	void copyAttributes(int x, int y, int count, unsigned char* destination) const;
+
+private:
+	//Remainder that is never negative, for the parts of a view left of or above the map
+	static int wrap(int value, int size) {
+		int remainder = value % size;
+		return remainder < 0 ? remainder + size : remainder;
+	}
+
+	void decodeColumn(const TileMap& map, int column, const Palette& palette);
+	void decodeRow(const TileMap& map, int row, const Palette& palette);
+	void decodeTile(const TileMap& map, int column, int row, const Palette& palette);
+
+	PixelFormat format;
+	int pixelSize;
+	std::vector<unsigned char> pixels; //RGBA or palette indices, WIDTH by HEIGHT
+	std::vector<unsigned char> bits; //Spectrum format, a byte per tile row
+	std::vector<unsigned char> attributes; //Spectrum format, one per tile
+	const TileMap* decodedMap = NULL; //What the window holds, NULL to decode it all again
+	unsigned int paletteVersion = 0;
+	int firstColumn = 0; //Map tile at the top left of the window
+	int firstRow = 0;
+};
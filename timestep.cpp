@@ -0,0 +1,23 @@
+#include "timestep.h"
+
+FixedTimestep::FixedTimestep(double tickRate) : tickLength(1.0 / tickRate), accumulator(0.0), droppedTicks(0) {
+}
+
+int FixedTimestep::advance(double elapsedSeconds) {
+	if (elapsedSeconds > 0.0) {
+		accumulator += elapsedSeconds;
+	}
+
+	int ticks = 0;
+	while (accumulator >= tickLength) {
+		accumulator -= tickLength;
+		ticks++;
+	}
+
+	if (ticks > MAX_TICKS_PER_FRAME) {
+		droppedTicks += ticks - MAX_TICKS_PER_FRAME;
+		ticks = MAX_TICKS_PER_FRAME;
+	}
+
+	return ticks;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+//Ticks per second, the same rate the Spectrum's 50Hz frame interrupt ran its games at
+static const double TICK_RATE = 50.0;
+
+//Turns real elapsed time into a whole number of fixed length ticks, keeping the remainder for the next frame.
+//Catching up is capped, so a long stall (a breakpoint, dragging the window) skips time instead of piling up ticks
+//that each make the next frame later still
+class FixedTimestep {
+public:
+	static const int MAX_TICKS_PER_FRAME = 5;
+
+	FixedTimestep(double tickRate = TICK_RATE);
+
+	//How many ticks to run for this much real time
+	int advance(double elapsedSeconds);
+
+	//How far between the last two ticks the leftover time is, from 0 to 1
+	double getAlpha() const { return accumulator / tickLength; }
+	double getTimeToNextTick() const { return tickLength - accumulator; }
+	//How long before the time advance() was called the given one of the ticks it returned falls
+	double getTickAge(int tick, int ticks) const { return accumulator + (ticks - 1 - tick) * tickLength; }
+	long long getDroppedTicks() const { return droppedTicks; }
+
+private:
+	double tickLength;
+	double accumulator;
+	long long droppedTicks;
+};
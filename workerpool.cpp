@@ -0,0 +1,89 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(int threadCount) : nextJob(0), jobsLeft(0) {
+	for (int i = 1; i < threadCount; i++) {
+		workers.push_back(std::thread(&WorkerPool::workerLoop, this));
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void WorkerPool::run(int count, const std::function<void(int)>& job) {
+	if (workers.empty() || count <= 1) {
+		for (int i = 0; i < count; i++) {
+			job(i);
+		}
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		//A slow worker from last time could still be looking at nextJob, don't reset it under its feet
+		finished.wait(lock, [this] { return busyWorkers == 0; });
+
+		this->job = &job;
+		jobCount = count;
+		nextJob = 0;
+		jobsLeft = count;
+		generation++;
+	}
+	wake.notify_all();
+
+	runJobs(&job, count);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return jobsLeft == 0; });
+}
+
+void WorkerPool::workerLoop() {
+	unsigned int seen = 0;
+
+	while (true) {
+		const std::function<void(int)>* currentJob;
+		int count;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) {
+				return;
+			}
+
+			seen = generation;
+			currentJob = job;
+			count = jobCount;
+			busyWorkers++;
+		}
+
+		runJobs(currentJob, count);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		finished.notify_all();
+	}
+}
+
+//Keep grabbing the next job until there are none left
+void WorkerPool::runJobs(const std::function<void(int)>* job, int count) {
+	int i;
+	while ((i = nextJob++) < count) {
+		(*job)(i);
+
+		if (--jobsLeft == 0) {
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.notify_all();
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Threads that stay alive for the whole run and split up jobs handed to them by run()
+class WorkerPool {
+public:
+	//The calling thread helps out too, so this starts threadCount - 1 workers
+	WorkerPool(int threadCount);
+	~WorkerPool();
+
+	//Run job(0) up to job(count - 1) spread over all threads, and only return once every one of them has finished
+	void run(int count, const std::function<void(int)>& job);
+
+private:
+	void workerLoop();
+	void runJobs(const std::function<void(int)>* job, int count);
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	const std::function<void(int)>* job = nullptr;
+	int jobCount = 0;
+	std::atomic<int> nextJob;
+	std::atomic<int> jobsLeft;
+	int busyWorkers = 0; //Workers that picked up the current jobs and may still touch nextJob
+	unsigned int generation = 0;
+	bool quit = false;
+};